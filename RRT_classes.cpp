@@ -1,18 +1,153 @@
 #include "RRT_classes.h"
+#include <cstring>
+#include <limits>
+#include <sstream>
 
 template<typename T>
 RRT_star<T>::RRT_star(int N, Environment& env_input, Obstacle& goal_in,
 		T& start_in){
 	N_points = N;
-	nodeList.reserve(N_points);
-	env = std::make_shared<Environment>(env_input);
+	reserveStorage(N_points);
+	auto envCopy = std::make_shared<Environment>(env_input);
+	if(!envCopy->hasObstacleGrid()){
+		envCopy->buildObstacleGrid();
+	}
+	env = envCopy;
+	goalRegion = std::make_shared<Obstacle>(goal_in);
+	start = std::make_shared<T>(start_in);
+}
+
+template<typename T>
+RRT_star<T>::RRT_star(int N, std::shared_ptr<const Environment> env_input,
+		Obstacle& goal_in, T& start_in){
+	N_points = N;
+	reserveStorage(N_points);
+	env = env_input;
 	goalRegion = std::make_shared<Obstacle>(goal_in);
 	start = std::make_shared<T>(start_in);
 }
 
+template<typename T>
+void RRT_star<T>::setSeed(unsigned int seed){
+	gen.seed(seed);
+}
+
+template<typename T>
+void RRT_star<T>::setSampleSource(std::shared_ptr<SampleSource> source){
+	sampleSource = source;
+}
+
+template<typename T>
+void RRT_star<T>::setRejectOccupiedSamples(const bool reject, const int maxAttempts){
+	assert(maxAttempts > 0);
+	rejectOccupiedSamples = reject;
+	maxSampleAttempts = maxAttempts;
+}
+
+template<typename T>
+std::shared_ptr<T> RRT_star<T>::sample(){
+	if(sampleSource != nullptr){
+		double u, v;
+		sampleSource->next(u, v);
+		return std::make_shared<T>(u * env->getDeltaX(), v * env->getDeltaY());
+	}
+	std::shared_ptr<T> p_item = std::make_shared<T>(T());
+	p_item->genRandom(*env, gen);
+	return p_item;
+}
+
+template<typename T>
+void RRT_star<T>::setSharedCostBound(std::shared_ptr<std::atomic<double>> bound){
+	sharedCostBound = bound;
+}
+
 template<typename T>
 void RRT_star<T>::addNode(std::shared_ptr<TreeNode<T>> newNode){
+	newNode->setIndex(nodeList.size());
 	nodeList.push_back(newNode);
+	auto parent = newNode->getParent();
+	if(parent != nullptr){
+		parent->addChild(newNode);
+	}
+	auto newItem = newNode->getItem();
+	nodeX.push_back(newItem->getX());
+	nodeY.push_back(newItem->getY());
+	streamCatchUp();
+	recordCheckpointEvent('N', newNode);
+}
+
+template<typename T>
+void RRT_star<T>::setDistanceField(std::shared_ptr<const DistanceField> field){
+	distanceField = field;
+}
+
+template<typename T>
+void RRT_star<T>::setStreamSink(std::shared_ptr<TreeStreamSink> sink){
+	streamSink = sink;
+	streamRestart();
+	streamCatchUp();
+}
+
+template<typename T>
+void RRT_star<T>::streamRestart(){
+	// readers drop their copy of the tree on 'C'
+	streamSentNodes = 0;
+	streamClearPending = true;
+}
+
+template<typename T>
+void RRT_star<T>::streamCatchUp(){
+	if(streamSink == nullptr){
+		return;
+	}
+	// half of the ring is kept for the events of nodes already sent, so
+	// catching up does not make them drop (and restart the stream)
+	const std::size_t reserve = streamSink->getCapacity() / 2;
+	if(streamClearPending){
+		if(streamSink->getFreeSlots() <= reserve){
+			return;
+		}
+		TreeEvent reset;
+		reset.type = 'C';
+		streamSink->push(reset);
+		streamClearPending = false;
+	}
+	while(streamSentNodes < nodeList.size() && streamSink->getFreeSlots() > reserve){
+		++streamSentNodes;
+		streamEvent('N', nodeList[streamSentNodes - 1]);
+	}
+}
+
+template<typename T>
+void RRT_star<T>::streamEvent(const char type,
+		const std::shared_ptr<TreeNode<T>> node){
+	if(streamSink == nullptr || node->getIndex() >= streamSentNodes){
+		return; // streamCatchUp sends the node as it is then
+	}
+	TreeEvent event;
+	event.type = type;
+	event.index = node->getIndex();
+	auto parent = node->getParent();
+	event.parent = parent == nullptr ? -1 : std::int64_t(parent->getIndex());
+	event.x = nodeX[event.index];
+	event.y = nodeY[event.index];
+	event.cost = node->getCost();
+	if(!streamSink->push(event)){
+		streamRestart();
+	}
+}
+
+template<typename T>
+void RRT_star<T>::streamRemoval(const std::size_t index){
+	if(streamSink == nullptr || index >= streamSentNodes){
+		return;
+	}
+	TreeEvent removal;
+	removal.type = 'D';
+	removal.index = index;
+	if(!streamSink->push(removal)){
+		streamRestart();
+	}
 }
 
 // Extend function has distinct steps:
@@ -28,9 +163,26 @@ template<typename T>
 bool RRT_star<T>::extend(const double radius){
 	bool extend_success = false; //keeps track of whether node if
 	//extend leads to a new TreeNode
+	RRT_STAT_ADD(iterations, 1);
+	RRT_STAT_TIMER(lap);
 	//Generate random point/item
-	std::shared_ptr<T> p_proposedItem = std::make_shared<T>(T());
-	p_proposedItem->genRandom(*env);
+	std::shared_ptr<T> p_proposedItem = sample();
+	// Samples inside an obstacle are redrawn before the nearest node search
+	// (one grid cell lookup), the nearest search and steering are only run
+	// for samples in free space
+	if(rejectOccupiedSamples){
+		int N_attempts = 1;
+		while(!env->pointFree(p_proposedItem->getX(), p_proposedItem->getY())){
+			RRT_STAT_ADD(rejectedSamples, 1);
+			if(N_attempts == maxSampleAttempts){
+				RRT_STAT_LAP(lap, samplingCycles);
+				return false;
+			}
+			p_proposedItem = sample();
+			++N_attempts;
+		}
+	}
+	RRT_STAT_LAP(lap, samplingCycles);
 	//std::cout << "Point generated: (" << p_proposedItem->getX() << ","<< p_proposedItem->getY() << ")" << std::endl;
 	// Find nearest node
 	std::shared_ptr<TreeNode<T>> nearestNode
@@ -38,87 +190,134 @@ bool RRT_star<T>::extend(const double radius){
 
 	// Steer towards generated point/item from nearest node
 	std::shared_ptr<T> newItem = steer(nearestNode, p_proposedItem);
+	RRT_STAT_LAP(lap, nearestCycles);
 	//std::cout << "Point steered to: (" << newItem->getX() << "," << newItem->getY() <<")" << std::endl;
 	// Check if new item can be reached through the nearest node
 	if(!collisionCheck(newItem, nearestNode->getItem())){
 		extend_success = true;
-		// make TreeNode object for the generated node
+		// make TreeNode object for the generated node, the nearest node is
+		// the parent unless a cheaper near node is found
 		std::shared_ptr<TreeNode<T>> newNode =
-			std::make_shared<TreeNode<T>>
-			(TreeNode<T>(newItem, nearestNode));
-
-		// Determine cost of new TreeNode
-		newNode->setCost(nearestNode->getCost()
-				+ calculateCost(newNode));
-		double bestCost = newNode->getCost();
+			std::make_shared<TreeNode<T>>(newItem, nearestNode);
+		double bestCost = nearestNode->getCost()
+			+ calculateEdgeCost(nearestNode->getItem(), newItem);
 		auto p_minNode = nearestNode;
 		// Get nearby nodes
-		auto p_nearNodes = getNearNodesParallel(newItem, radius);
-		for(auto nearNode : p_nearNodes){
-		// For each nearby node, check if generated node can be
-		// reached through the nearby node
-		// If so, calculate cost to do so and see if the path is
-		// better than the current path through the nearest node
-		// If cost is lower, prefer this path instead
-			if(!collisionCheck(newItem, nearNode->getItem())){
-				newNode->setParent(nearNode);
-				double nearCost = nearNode->getCost()
-					+ calculateCost(newNode);
-				if(nearCost < bestCost){
-					bestCost = nearCost;
-					p_minNode = nearNode;
-				}
+		RRT_STAT_RESTART(lap);
+		getNearNodesParallel(newItem, radius);
+		RRT_STAT_LAP(lap, nearCycles);
+		const std::size_t N_near = nearIndices.size();
+		RRT_STAT_ADD(nearQueries, 1);
+		RRT_STAT_ADD(nearNodesTotal, N_near);
+		RRT_STAT_MAX(nearNodesMax, N_near);
+
+		// Edge costs are computed once per near node (the squared distances
+		// of the near search are the default cost) and reused for rewiring
+		nearEdgeCost.resize(N_near);
+		nearPathCost.resize(N_near);
+		candidateOrder.resize(N_near);
+		nearCollision.assign(N_near, 0);
+		for(std::size_t k = 0; k < N_near; ++k){
+			const auto& nearNode = nodeList[nearIndices[k]];
+			nearEdgeCost[k] = edgeCost ?
+				edgeCost(nearNode->getItem(), newItem) : nearDistSq[k];
+			nearPathCost[k] = nearNode->getCost() + nearEdgeCost[k];
+			candidateOrder[k] = k;
+		}
+		// Candidates in order of the cost through them: the first one that
+		// is cheaper than the current parent and collision free is the best
+		// parent, the others are not collision checked at all
+		std::sort(candidateOrder.begin(), candidateOrder.end(),
+			[this](const std::uint32_t a, const std::uint32_t b){
+				return nearPathCost[a] < nearPathCost[b];});
+		for(auto k : candidateOrder){
+			if(nearPathCost[k] >= bestCost){
+				break;
+			}
+			const auto& nearNode = nodeList[nearIndices[k]];
+			nearCollision[k] = collisionCheck(newItem, nearNode->getItem()) ? 2 : 1;
+			if(nearCollision[k] == 1){
+				bestCost = nearPathCost[k];
+				p_minNode = nearNode;
+				break;
 			}
 		}
 
-		// Check if nearby nodes can be reached through the
-		// generated node at a lower cost than the cost
-		// to reach them currently. If so, rewire to go through
-		// generated node
+		RRT_STAT_LAP(lap, parentSelectionCycles);
+
+		// A node that cannot lead to a path cheaper than the best known one
+		// (own best path once a cost-to-go is set, and the shared bound of a
+		// group of planners) is not added
+		double costBound = std::numeric_limits<double>::infinity();
+		if(sharedCostBound != nullptr){
+			costBound = sharedCostBound->load(std::memory_order_relaxed);
+		}
+		if(costToGo){
+			costBound = std::min(costBound, getBestCost());
+		}
+		if(costBound < std::numeric_limits<double>::infinity() &&
+				bestCost + (costToGo ? costToGo(newItem) : 0.0) >= costBound){
+			RRT_STAT_ADD(prunedNodes, 1);
+			return false;
+		}
+
 		newNode->setParent(p_minNode);
 		newNode->setCost(bestCost);
-		for(auto nearNode : p_nearNodes){
-			if(nearNode != p_minNode){
-				auto parentNode_org = nearNode->getParent();
-				nearNode->setParent(newNode);
-				if(!collisionCheck
-					(newItem,nearNode->getItem()) &&
-					nearNode->getCost() >
-					newNode->getCost()
-					  + calculateCost(nearNode)){
-
-					nearNode->setCost(newNode->getCost() + calculateCost(nearNode));
-					nearNode->setParent(newNode);
+		addNode(newNode); // added first so that rewire events can refer to it
 
-				}
-				else{
-					nearNode->setParent(parentNode_org);
-				}
+		// Check if nearby nodes can be reached through the
+		// generated node at a lower cost than the cost
+		// to reach them currently. If so, rewire to go through
+		// generated node. The cost test comes first, collision checks
+		// are only run for improvements (or reused from parent selection)
+		for(std::size_t k = 0; k < N_near; ++k){
+			auto nearNode = nodeList[nearIndices[k]];
+			if(nearNode == p_minNode){
+				continue;
+			}
+			double newCost = bestCost + (symmetricEdgeCost ? nearEdgeCost[k]
+				: calculateEdgeCost(newItem, nearNode->getItem()));
+			if(newCost >= nearNode->getCost()){
+				continue;
+			}
+			if(nearCollision[k] == 0){
+				nearCollision[k] = collisionCheck(newItem, nearNode->getItem()) ? 2 : 1;
+			}
+			if(nearCollision[k] == 1){
+				double oldCost = nearNode->getCost();
+				linkParent(nearNode, newNode);
+				nearNode->setCost(newCost);
+				propagateCost(nearNode, oldCost - newCost);
+				RRT_STAT_ADD(rewires, 1);
+				streamEvent('R', nearNode);
+				recordCheckpointEvent('R', nearNode);
 			}
 		}
-		addNode(newNode);
+		RRT_STAT_LAP(lap, rewireCycles);
+		RRT_STAT_ADD(extendSuccesses, 1);
 	}
 	return extend_success;
 }
 
-// collisionCheck iterates through Obstacles in the Environment object used
-// to see if the line connecting two items/points results in a collision
+// collisionCheck tests the Obstacles in the Environment object used (those
+// in the grid cells around the line, see Environment::segmentFree) to see if
+// the line connecting two items/points results in a collision
 // Boolean indicates whether or not collision happens
 template<typename T>
 bool RRT_star<T>::collisionCheck(std::shared_ptr<T> p1, std::shared_ptr<T> p2){
-	bool collision = false;
-	if(env->obstacleFree(p1) && env->obstacleFree(p2)){
-		std::shared_ptr<Line> proposedLine = std::make_shared<Line>(p1, p2);
-		for(auto ob : env->getObstacleList()){
-			if(ob->lineIntersects(proposedLine)){
-				collision = true;
-				break;
-			}
-		}
-	}
-	else{
-		collision = true;
+	RRT_STAT_TIMER(lap);
+	RRT_STAT_ADD(collisionChecks, 1);
+	if(distanceField != nullptr && distanceField->segmentClear(p1->getX(),
+			p1->getY(), p2->getX(), p2->getY())){
+		RRT_STAT_ADD(clearanceAccepts, 1);
+		RRT_STAT_LAP(lap, collisionCycles);
+		return false;
 	}
+	std::uint64_t N_obstacleTests = 0;
+	bool collision = !env->segmentFree(p1->getX(), p1->getY(),
+			p2->getX(), p2->getY(), &N_obstacleTests);
+	RRT_STAT_ADD(obstacleTests, N_obstacleTests);
+	RRT_STAT_LAP(lap, collisionCycles);
 	return collision;
 }
 
@@ -130,73 +329,53 @@ std::shared_ptr<TreeNode<T>> RRT_star<T>::getNearestNodeParallel(
 	if(nodeList.size() < 100000){return getNearestNode_single(p_proposedItem);}
 
 	int N_tasks = 8;
-	std::pair<double,std::shared_ptr<TreeNode<T>>> worker_best =
-		std::make_pair<double,std::shared_ptr<TreeNode<T>>>(0,nullptr);
-	int N_splitNodes = nodeList.size()/N_tasks;
-	std::vector<std::future<std::pair<double,std::shared_ptr<TreeNode<T>>>>> threaded_futures;
+	std::pair<double,std::size_t> worker_best =
+		std::make_pair(0.0,nodeList.size());
+	std::size_t N_splitNodes = nodeList.size()/N_tasks;
+	std::vector<std::future<std::pair<double,std::size_t>>> threaded_futures;
 
 	for(int i = 0; i<N_tasks;++i){ //starting threads
-		auto start_it = nodeList.cbegin()+ i * (N_splitNodes);
-		auto end_it = i == N_tasks-1 ? nodeList.cend() : nodeList.cbegin() + (i+1) * N_splitNodes;
+		std::size_t start_i = i * N_splitNodes;
+		std::size_t end_i = i == N_tasks-1 ? nodeList.size() : (i+1) * N_splitNodes;
 		// bind with worker function with lambda function
 		auto task = [this](const std::shared_ptr<T> p,
-		const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_i,
-		const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_i){
-				return getNearestNode_worker(p,start_i,end_i);};
+		const std::size_t start_idx, const std::size_t end_idx){
+				return getNearestNode_worker(p,start_idx,end_idx);};
 
 		// start async task
-		threaded_futures.emplace_back(async(task,p_proposedItem,start_it,end_it));
+		threaded_futures.emplace_back(async(task,p_proposedItem,start_i,end_i));
 	}
 
+	// ranges are joined in order, so on a tie the lower index is kept
 	for(int i = 0; i < N_tasks; ++i){
-		std::pair<double,std::shared_ptr<TreeNode<T>>> local_best = threaded_futures[i].get();
-		if(local_best.first > worker_best.first){worker_best = local_best;}
+		std::pair<double,std::size_t> local_best = threaded_futures[i].get();
+		if(worker_best.second == nodeList.size() ||
+				local_best.first < worker_best.first){worker_best = local_best;}
 	}
 
-	return worker_best.second;
+	return nodeList[worker_best.second];
 }
 
 template<typename T>
 std::shared_ptr<TreeNode<T>> RRT_star<T>::getNearestNode_single(
 	const std::shared_ptr<T> p_proposedItem) const{
 
-	std::shared_ptr<TreeNode<T>> current_nearestNode = nullptr;
-	double bestDistance = env->getMaxDistance();
-	bestDistance *= bestDistance; // Used to accomodate Point::calculateCost usage instead of calculateDistance
-	for (auto p_node_check : nodeList){
-		auto p_item_check = p_node_check->getItem();
-		auto distance =
-			p_proposedItem->calculateCost(p_item_check); // Point::calculateCost is distance without the sqrt
-		if(distance < bestDistance ||
-				current_nearestNode ==nullptr){
-			current_nearestNode = p_node_check;
-			bestDistance = distance;
-		}
-	}
-	return current_nearestNode;
+	return nodeList[getNearestNode_worker(p_proposedItem, 0,
+			nodeList.size()).second];
 }
 
 template<typename T>
-std::pair<double,std::shared_ptr<TreeNode<T>>> RRT_star<T>::getNearestNode_worker(
+std::pair<double,std::size_t> RRT_star<T>::getNearestNode_worker(
 	const std::shared_ptr<T> p_proposedItem,
-	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_i,
-	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_i) const{
+	const std::size_t start_i,
+	const std::size_t end_i) const{
 
-	std::shared_ptr<TreeNode<T>> current_nearestNode = nullptr;
 	double bestDistance = env->getMaxDistance();
-	bestDistance *= bestDistance; // Used to accomodate Point::calculateCost usage instead of calculateDistance
-	for (auto it = start_i; it < end_i; ++it){
-		auto p_node_check = *it;
-		auto p_item_check = p_node_check->getItem();
-		auto distance =
-			p_proposedItem->calculateCost(p_item_check); // Point::calculateCost is distance without the sqrt
-		if(distance < bestDistance ||
-				current_nearestNode ==nullptr){
-			current_nearestNode = p_node_check;
-			bestDistance = distance;
-		}
-	}
-	return std::make_pair(bestDistance,current_nearestNode);
+	bestDistance *= bestDistance; // squared, same as Point::calculateCost
+	std::size_t bestIndex = nearestIndexBatch(nodeX.data(), nodeY.data(),
+		start_i, end_i, p_proposedItem->getX(), p_proposedItem->getY(),
+		bestDistance);
+	return std::make_pair(bestDistance,bestIndex);
 }
 
 template<typename T>
@@ -208,93 +387,56 @@ std::shared_ptr<T> RRT_star<T>::steer(const std::shared_ptr<TreeNode<T>> p_neare
 }
 
 template<typename T>
-std::vector<std::shared_ptr<TreeNode<T>>> RRT_star<T>::getNearNodesParallel(
-	const std::shared_ptr<T> p_node, const double radius){
-		int N_threads = 8;
-		if(nodeList.size() > N_threads*10000){
-			int N_splitNodes = nodeList.size()/N_threads;
-			using Task_type = std::vector<std::shared_ptr<TreeNode<T>>>(std::shared_ptr<T>,
-			double, std::vector<std::shared_ptr<TreeNode<T>>>);
-
-			std::vector<std::packaged_task<Task_type>> threaded_tasks;
-			std::vector<std::future<std::vector<std::shared_ptr<TreeNode<T>>>>> threaded_futures;
-
-			// // Packaging tasks
-			// for(int i = 0; i<N_threads; ++i){
-			// 	//create packaged_task via. lambda function
-			// 	std::packaged_task<Task_type> pt([this](std::shared_ptr<T> p, double r,
-			// 	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_i,
-			// 	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_i){
-			// 		return getNearNodes_worker(p,r,start_i,end_i);});
-			//
-			// 	assert(pt.valid());
-			//
-			// 	threaded_futures.emplace_back(pt.get_future());
-			// 	threaded_tasks.push_back(std::move(pt));
-			//
-			// }
-			//
-			//start threads
-			//std::vector<std::thread> thread_workers;
+void RRT_star<T>::getNearNodesParallel(const std::shared_ptr<T> p_node,
+		const double radius){
+		int N_threads = N_nearTasks;
+		if(nodeList.size() > std::size_t(N_threads)*10000){
+			std::size_t N_splitNodes = nodeList.size()/N_threads;
+			taskIndices.resize(N_threads);
+			taskDistSq.resize(N_threads);
+			std::vector<std::future<void>> threaded_futures;
+
 			for(int i = 0; i<N_threads;++i){ //starting threads
-				auto start_it = nodeList.cbegin()+ i * (N_splitNodes);
-				auto end_it = i == N_threads-1 ? nodeList.cend() : nodeList.cbegin() + (i+1) * N_splitNodes;
-				// bind with worker function with lambda function
-				auto task = [this](std::shared_ptr<T> p, double r,
-				 	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_i,
-				 	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_i){
-				 		return getNearNodes_worker(p,r,start_i,end_i);};
-				threaded_futures.emplace_back(async(task,p_node,
-				radius,start_it,end_it));
-				// thread_workers.emplace_back(std::move(threaded_tasks[i]),
-				// p_node,radius,start_it, end_it);
+				std::size_t start_i = i * N_splitNodes;
+				std::size_t end_i = i == N_threads-1 ? nodeList.size() : (i+1) * N_splitNodes;
+				// each task writes to its own result buffers
+				auto task = [this, p_node, radius, i, start_i, end_i](){
+				 		getNearNodes_worker(p_node, radius, start_i, end_i,
+							taskIndices[i], taskDistSq[i]);};
+				threaded_futures.emplace_back(std::async(task));
 			}
 
-			// concatenate vector results
-			std::vector<std::shared_ptr<TreeNode<T>>> returnVect;
-
+			// concatenate results, tasks cover increasing index ranges
+			nearIndices.clear();
+			nearDistSq.clear();
 			for(int i = 0; i<N_threads; ++i){
-				//thread_workers[i].join();
-				std::vector<std::shared_ptr<TreeNode<T>>> fut = threaded_futures[i].get();
-				returnVect.insert(returnVect.end(),fut.begin(),fut.end());
+				threaded_futures[i].get();
+				nearIndices.insert(nearIndices.end(), taskIndices[i].begin(),
+						taskIndices[i].end());
+				nearDistSq.insert(nearDistSq.end(), taskDistSq[i].begin(),
+						taskDistSq[i].end());
 			}
-			return returnVect;
 		}
-		else{return getNearNodes_single(p_node,radius);}
+		else{getNearNodes_single(p_node,radius);}
 	}
 
 template<typename T>
-std::vector<std::shared_ptr<TreeNode<T>>> RRT_star<T>::getNearNodes_worker(const std::shared_ptr<T> p_node,
-	const double radius, const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator startIt,
-	const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator endIt) const{
+void RRT_star<T>::getNearNodes_worker(const std::shared_ptr<T> p_node,
+	const double radius, const std::size_t start_i,
+	const std::size_t end_i, std::vector<std::size_t>& indices,
+	std::vector<double>& distSq) const{
 
-	std::vector<std::shared_ptr<TreeNode<T>>> nearNodeList;
-
-	for (auto it = startIt; it < endIt; ++it){
-		std::shared_ptr<TreeNode<T>> node_check = *it;
-		auto p_item = node_check->getItem();
-		auto distance = p_item->calculateCost(p_node); // Point::calculateCost is distance without the sqrt
-		double r = radius*radius;
-		if(distance <= r){
-			nearNodeList.push_back(node_check);
-		}
-	}
-	return nearNodeList;
+	indices.clear();
+	distSq.clear();
+	nearIndicesBatch(nodeX.data(), nodeY.data(), start_i, end_i,
+		p_node->getX(), p_node->getY(), radius*radius, indices, &distSq);
 }
 
 template<typename T>
-std::vector<std::shared_ptr<TreeNode<T>>> RRT_star<T>::getNearNodes_single(const std::shared_ptr<T> p_node, const double radius) const{
-	std::vector<std::shared_ptr<TreeNode<T>>> nearNodeList;
-
-	for (auto p_node_check : nodeList){
-		auto p_item = p_node_check->getItem();
-		auto distance = p_item->calculateCost(p_node); // Point::calculateCost is distance without the sqrt
-		double r = radius*radius;
-		if(distance <= r){
-			nearNodeList.push_back(p_node_check);
-		}
-	}
-	return nearNodeList;
+void RRT_star<T>::getNearNodes_single(const std::shared_ptr<T> p_node,
+		const double radius){
+	getNearNodes_worker(p_node, radius, 0, nodeList.size(), nearIndices,
+			nearDistSq);
 }
 
 template<typename T>
@@ -302,11 +444,44 @@ double RRT_star<T>::calculateCost(const std::shared_ptr<TreeNode<T>> node) const
 	std::shared_ptr<T> item_cur = node->getItem();
         std::shared_ptr<TreeNode<T>> parent = node->getParent();
 	std::shared_ptr<T> item_par = parent->getItem();
-	return item_cur->calculateCost(item_par);
+	return calculateEdgeCost(item_par, item_cur);
+}
+
+template<typename T>
+double RRT_star<T>::calculateEdgeCost(const std::shared_ptr<T> parentItem,
+		const std::shared_ptr<T> childItem) const{
+	if(edgeCost){
+		return edgeCost(parentItem, childItem);
+	}
+	return childItem->calculateCost(parentItem);
+}
+
+template<typename T>
+void RRT_star<T>::setEdgeCost(EdgeCostFunction<T> cost, const bool symmetric){
+	edgeCost = cost;
+	symmetricEdgeCost = symmetric;
+}
+
+template<typename T>
+void RRT_star<T>::setCostToGo(CostToGoFunction<T> heuristic){
+	costToGo = heuristic;
 }
 
 template<typename T>
 void RRT_star<T>::initiate(double radius){
+	initializeTree();
+	while(N_iterations + 1 < std::uint64_t(N_points)){
+		iterate(radius);
+	}
+}
+
+template<typename T>
+int RRT_star<T>::getNumPoints() const{
+	return N_points;
+}
+
+template<typename T>
+void RRT_star<T>::initializeTree(){
 	// Required assumptions:
 	// 1) goalRegion sits in the environment env
 	// 2) goalRegion is a region (not a single point)
@@ -329,40 +504,454 @@ void RRT_star<T>::initiate(double radius){
 	assert(goalRegion_x_inEnvironment);
 	assert(goalRegion_y_inEnvironment);
 
-	// main routine
+	// main routine, a tree loaded from a snapshot already has its root
+	if(!nodeList.empty()){
+		return;
+	}
 	std::shared_ptr<TreeNode<T>> startNode =
 		std::make_shared<TreeNode<T>>(TreeNode<T>(start)); //make startNode
-	nodeList.push_back(startNode); //add start node
-	for(int i = 1; i < N_points; i++){
-		bool extendSuccess =  extend(radius);
-		if(extendSuccess){
-			//std::cout << "RRT node added at iteration: " << i << std::endl;
-			auto lastItemAdded = nodeList.back()->getItem();
-			if(goalRegion->inObstacle(lastItemAdded)){
-				goalNodes.push_back(nodeList.back());
-			//	std::cout << "Goal reached at iteration: "<< i << std::endl;
+	addNode(startNode); //add start node
+}
+
+template<typename T>
+bool RRT_star<T>::iterate(double radius){
+	++N_iterations;
+	bool extendSuccess =  extend(radius);
+	if(extendSuccess){
+		addGoalCandidate(nodeList.back());
+		if(compactionInterval > 0 && ++nodesSinceCompaction >= compactionInterval){
+			compactTree();
+		}
+		// bounded mode: the new node pushed the tree over the budget
+		while(maxNodes > 0 && nodeList.size() > maxNodes){
+			if(!evictNode()){
+				throw std::runtime_error("Memory budget too small for the best path");
 			}
 		}
+	}
+	streamCatchUp(); // the new node, or what a restarted stream still lacks
+	if(checkpointInterval > 0 && N_iterations % checkpointInterval == 0){
+		checkpoint();
+	}
+	return extendSuccess;
+}
+
+template<typename T>
+void RRT_star<T>::addGoalCandidate(const std::shared_ptr<TreeNode<T>> node){
+	if(goalRegion->inObstacle(node->getItem())){
+		goalNodes.push_back(node);
+		updateBestGoal(node);
+	}
+}
+
+template<typename T>
+std::uint64_t RRT_star<T>::getIterations() const{
+	return N_iterations;
+}
+
+template<typename T>
+std::size_t RRT_star<T>::nodeObjectBytes(){
+	// one make_shared allocation each for the node and its item (object,
+	// control block, allocator header), and each node is one entry of its
+	// parent's children list (amortized vector growth)
+	const std::size_t allocationOverhead = 16;
+	return sizeof(TreeNode<T>) + sizeof(T) + 4 * allocationOverhead
+		+ 2 * sizeof(std::weak_ptr<TreeNode<T>>) + allocationOverhead;
+}
+
+template<typename T>
+std::size_t RRT_star<T>::bytesPerNode(){
+	// node list and coordinates, plus one entry of each list that can grow
+	// to the size of the tree: goal list, propagation stack and the near
+	// search scratch (the near set of a large radius is the whole tree)
+	const std::size_t pointerBytes = sizeof(std::shared_ptr<TreeNode<T>>);
+	return nodeObjectBytes() + pointerBytes + 2 * sizeof(double)
+		+ 2 * pointerBytes
+		+ 2 * sizeof(std::size_t) + 4 * sizeof(double)
+		+ sizeof(std::uint32_t) + sizeof(char);
+}
+
+template<typename T>
+std::size_t RRT_star<T>::storageCapacity() const{
+	std::size_t capacity = std::max(N_points, 1);
+	if(maxNodes > 0){
+		capacity = std::min(capacity, maxNodes + 1); // +1, eviction follows the addition
+	}
+	return capacity;
+}
+
+template<typename T>
+void RRT_star<T>::reserveStorage(const std::size_t capacity){
+	// a fresh vector and swap, reserve alone never shrinks
+	auto setCapacity = [capacity](auto& list){
+		if(list.capacity() > capacity && list.size() <= capacity){
+			std::remove_reference_t<decltype(list)> newList;
+			newList.reserve(capacity);
+			newList.assign(list.begin(), list.end());
+			list.swap(newList);
+		}
 		else{
-			//std::cout << "Extend failed at iteration: " << i << std::endl;
+			list.reserve(capacity);
+		}
+	};
+	setCapacity(nodeList);
+	setCapacity(nodeX);
+	setCapacity(nodeY);
+	if(maxNodes > 0){
+		// bounded mode: the lists that grow with the tree never reallocate
+		setCapacity(goalNodes);
+		setCapacity(propagationStack);
+		setCapacity(nearIndices);
+		setCapacity(nearDistSq);
+		setCapacity(nearEdgeCost);
+		setCapacity(nearPathCost);
+		setCapacity(candidateOrder);
+		setCapacity(nearCollision);
+		taskIndices.clear();
+		taskDistSq.clear();
+		if(capacity > std::size_t(N_nearTasks) * 10000){
+			// each task of the parallel search covers an equal index range
+			taskIndices.resize(N_nearTasks);
+			taskDistSq.resize(N_nearTasks);
+			for(int i = 0; i < N_nearTasks; ++i){
+				taskIndices[i].reserve(capacity / N_nearTasks + N_nearTasks);
+				taskDistSq[i].reserve(capacity / N_nearTasks + N_nearTasks);
+			}
 		}
+	}
+}
 
+template<typename T>
+void RRT_star<T>::setMemoryBudget(const std::size_t bytes){
+	memoryBudget = bytes;
+	maxNodes = 0;
+	if(memoryBudget > 0){
+		// the remaining tenth covers allocator slack and fixed costs
+		maxNodes = std::max<std::size_t>(memoryBudget * 9 / 10 / bytesPerNode(), 2);
 	}
+	reserveStorage(storageCapacity());
 }
 
 template<typename T>
-TreeAncestorPath<T> RRT_star<T>::getFinalPath(){
-	double currentBestCost = -1;
-	std::shared_ptr<TreeNode<T>> bestGoalNode;
-	assert(!goalNodes.empty());
-	for(auto p_node_check : goalNodes){
-		if(currentBestCost == -1 ||
-				p_node_check->getCost() < currentBestCost){
-			bestGoalNode = p_node_check;
-			currentBestCost = p_node_check->getCost();
+std::size_t RRT_star<T>::getMemoryUsage() const{
+	const std::size_t pointerBytes = sizeof(std::shared_ptr<TreeNode<T>>);
+	std::size_t taskBytes = 0;
+	for(int i = 0; i < int(taskIndices.size()); ++i){
+		taskBytes += taskIndices[i].capacity() * sizeof(std::size_t)
+			+ taskDistSq[i].capacity() * sizeof(double);
+	}
+	return nodeList.size() * nodeObjectBytes()
+		+ nodeList.capacity() * pointerBytes
+		+ (nodeX.capacity() + nodeY.capacity()) * sizeof(double)
+		+ (goalNodes.capacity() + propagationStack.capacity()) * pointerBytes
+		+ nearIndices.capacity() * sizeof(std::size_t)
+		+ (nearDistSq.capacity() + nearEdgeCost.capacity()
+				+ nearPathCost.capacity()) * sizeof(double)
+		+ candidateOrder.capacity() * sizeof(std::uint32_t)
+		+ nearCollision.capacity() * sizeof(char) + taskBytes;
+}
+
+template<typename T>
+std::size_t RRT_star<T>::getMaxNodes() const{
+	return maxNodes;
+}
+
+template<typename T>
+bool RRT_star<T>::evictNode(){
+	// worst of a few random leaves: highest cost to come, never the root or
+	// the best goal node (its ancestors are inner nodes, so the best path
+	// stays whole)
+	std::uniform_int_distribution<std::size_t> indexDistribution(1, nodeList.size() - 1);
+	std::shared_ptr<TreeNode<T>> p_worst;
+	for(int k = 0; k < evictionSamples; ++k){
+		const auto& p_node = nodeList[indexDistribution(gen)];
+		if(!p_node->getChildren().empty() || p_node == bestGoalNode){
+			continue;
+		}
+		if(p_worst == nullptr || p_node->getCost() > p_worst->getCost()){
+			p_worst = p_node;
+		}
+	}
+	if(p_worst == nullptr){
+		// mostly inner nodes: any leaf, scanning from a random start
+		const std::size_t N = nodeList.size();
+		const std::size_t first = indexDistribution(gen);
+		for(std::size_t k = 0; k < N - 1 && p_worst == nullptr; ++k){
+			const auto& p_node = nodeList[1 + (first - 1 + k) % (N - 1)];
+			if(p_node->getChildren().empty() && p_node != bestGoalNode){
+				p_worst = p_node;
+			}
+		}
+	}
+	if(p_worst == nullptr){
+		return false;
+	}
+	if(goalRegion->inObstacle(p_worst->getItem())){
+		auto it = std::find(goalNodes.begin(), goalNodes.end(), p_worst);
+		if(it != goalNodes.end()){
+			*it = goalNodes.back();
+			goalNodes.pop_back();
+		}
+	}
+	const std::size_t i = p_worst->getIndex();
+	p_worst->getParent()->removeChild(p_worst);
+	streamRemoval(i);
+	// swap-remove: the last node takes the free slot
+	const std::size_t last = nodeList.size() - 1;
+	if(i != last){
+		nodeList[i] = nodeList[last];
+		nodeX[i] = nodeX[last];
+		nodeY[i] = nodeY[last];
+		nodeList[i]->setIndex(i);
+		// moved node and the parent index of its children
+		streamRemoval(last);
+		streamEvent('N', nodeList[i]);
+		for(const auto& w_child : nodeList[i]->getChildren()){
+			streamEvent('R', w_child.lock());
+		}
+	}
+	nodeList.pop_back();
+	nodeX.pop_back();
+	nodeY.pop_back();
+	streamSentNodes = std::min(streamSentNodes, nodeList.size());
+	RRT_STAT_ADD(evictedNodes, 1);
+	needFullCheckpoint = true;
+	checkpointEvents.clear();
+	return true;
+}
+
+template<typename T>
+std::uint32_t RRT_star<T>::mortonCode(const double x, const double y) const{
+	auto quantize = [](const double value, const double size){
+		double scaled = value / size * 65535.0;
+		return std::uint32_t(std::min(std::max(scaled, 0.0), 65535.0));
+	};
+	// spreads the 16 bits of v to the even bits of the result
+	auto spread = [](std::uint32_t v){
+		v = (v | (v << 8)) & 0x00FF00FFu;
+		v = (v | (v << 4)) & 0x0F0F0F0Fu;
+		v = (v | (v << 2)) & 0x33333333u;
+		v = (v | (v << 1)) & 0x55555555u;
+		return v;
+	};
+	return spread(quantize(x, env->getDeltaX()))
+		| (spread(quantize(y, env->getDeltaY())) << 1);
+}
+
+template<typename T>
+void RRT_star<T>::compactTree(){
+	nodesSinceCompaction = 0;
+	const std::size_t N = nodeList.size();
+	if(N < 3){
+		return;
+	}
+	if(maxNodes > 0){
+		// bounded mode: copying the nodes would briefly double the tree.
+		// The node objects stay where they are and only the storage order
+		// changes, sorted and permuted in the extend scratch buffers, which
+		// are reserved for the whole tree, so nothing is allocated.
+		// Keys are the Morton code above the old index (root first, ties
+		// keep the old order).
+		nearIndices.resize(N);
+		nearIndices[0] = 0;
+		for(std::size_t i = 1; i < N; ++i){
+			nearIndices[i] = (std::uint64_t(mortonCode(nodeX[i], nodeY[i])) << 32) | i;
+		}
+		std::sort(nearIndices.begin() + 1, nearIndices.end());
+		// position k takes the node at old index nearIndices[k] (low bits),
+		// applied one cycle of the permutation at a time
+		nearCollision.assign(N, 0);
+		for(std::size_t k = 0; k < N; ++k){
+			if(nearCollision[k] != 0){
+				continue;
+			}
+			auto p_first = std::move(nodeList[k]);
+			const double x = nodeX[k];
+			const double y = nodeY[k];
+			std::size_t j = k;
+			while(true){
+				nearCollision[j] = 1;
+				const std::size_t from = nearIndices[j] & 0xFFFFFFFFu;
+				if(from == k){
+					break;
+				}
+				nodeList[j] = std::move(nodeList[from]);
+				nodeX[j] = nodeX[from];
+				nodeY[j] = nodeY[from];
+				j = from;
+			}
+			nodeList[j] = std::move(p_first);
+			nodeX[j] = x;
+			nodeY[j] = y;
+		}
+		nearIndices.clear();
+		nearCollision.clear();
+		for(std::size_t k = 0; k < N; ++k){
+			nodeList[k]->setIndex(k);
+		}
+		needFullCheckpoint = true; // indices changed, earlier events no longer apply
+		checkpointEvents.clear();
+		streamRestart(); // every index changed, the tree is sent again
+		return;
+	}
+
+	// new order: root first, then the other nodes by Morton code (ties
+	// keep the old order)
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> order;
+	order.reserve(N);
+	order.emplace_back(0, 0);
+	for(std::size_t i = 1; i < N; ++i){
+		order.emplace_back(mortonCode(nodeX[i], nodeY[i]), i);
+	}
+	std::sort(order.begin() + 1, order.end());
+
+	// node and item objects are rebuilt in the new order so that they are
+	// allocated next to each other as well
+	std::vector<std::shared_ptr<TreeNode<T>>> newList;
+	std::vector<double> newX;
+	std::vector<double> newY;
+	newList.reserve(std::max(N, storageCapacity()));
+	newX.reserve(std::max(N, storageCapacity()));
+	newY.reserve(std::max(N, storageCapacity()));
+	for(std::size_t k = 0; k < N; ++k){
+		const auto& oldNode = nodeList[order[k].second];
+		auto p_node = std::make_shared<TreeNode<T>>(
+			std::make_shared<T>(*oldNode->getItem()));
+		p_node->setCost(oldNode->getCost());
+		newList.push_back(p_node);
+		newX.push_back(nodeX[order[k].second]);
+		newY.push_back(nodeY[order[k].second]);
+	}
+	// old indices are still in the old nodes, new ones are set once all
+	// parents are linked
+	std::vector<std::uint32_t> newIndex(N);
+	for(std::size_t k = 0; k < N; ++k){
+		newIndex[order[k].second] = k;
+	}
+	for(std::size_t k = 0; k < N; ++k){
+		auto oldParent = nodeList[order[k].second]->getParent();
+		if(oldParent != nullptr){
+			linkParent(newList[k], newList[newIndex[oldParent->getIndex()]]);
+		}
+	}
+	for(auto& p_goal : goalNodes){
+		p_goal = newList[newIndex[p_goal->getIndex()]];
+	}
+	if(bestGoalNode != nullptr){
+		bestGoalNode = newList[newIndex[bestGoalNode->getIndex()]];
+	}
+	for(std::size_t k = 0; k < N; ++k){
+		newList[k]->setIndex(k);
+	}
+	nodeList.swap(newList);
+	nodeX.swap(newX);
+	nodeY.swap(newY);
+	propagationStack.clear();
+	needFullCheckpoint = true; // indices changed, earlier events no longer apply
+	checkpointEvents.clear();
+
+	streamRestart(); // every index changed, the tree is sent again
+}
+
+template<typename T>
+void RRT_star<T>::setCompactionInterval(const std::size_t interval){
+	compactionInterval = interval;
+	nodesSinceCompaction = 0;
+}
+
+template<typename T>
+RRT_stats RRT_star<T>::getStats() const{
+	return stats.snapshot();
+}
+
+template<typename T>
+bool RRT_star<T>::pathFound() const{
+	return bestGoalNode != nullptr;
+}
+
+template<typename T>
+std::shared_ptr<TreeNode<T>> RRT_star<T>::getBestGoalNode() const{
+	assert(bestGoalNode != nullptr);
+	return bestGoalNode;
+}
+
+template<typename T>
+double RRT_star<T>::getBestCost() const{
+	return bestGoalNode == nullptr ? std::numeric_limits<double>::infinity()
+		: bestGoalNode->getCost();
+}
+
+template<typename T>
+void RRT_star<T>::setBestCostCallback(std::function<void(double,
+		std::shared_ptr<TreeNode<T>>)> callback){
+	bestCostCallback = callback;
+}
+
+template<typename T>
+void RRT_star<T>::updateBestGoal(const std::shared_ptr<TreeNode<T>> goalNode){
+	if(bestGoalNode == nullptr || goalNode->getCost() < bestGoalNode->getCost()){
+		bestGoalNode = goalNode;
+		if(bestCostCallback){
+			bestCostCallback(goalNode->getCost(), goalNode);
+		}
+	}
+	else if(goalNode == bestGoalNode && bestCostCallback){
+		bestCostCallback(goalNode->getCost(), goalNode); // best node itself got cheaper
+	}
+	if(goalNode == bestGoalNode && sharedCostBound != nullptr){
+		// lower the shared bound if this path beats it
+		double bound = sharedCostBound->load(std::memory_order_relaxed);
+		while(goalNode->getCost() < bound &&
+			!sharedCostBound->compare_exchange_weak(bound, goalNode->getCost(),
+				std::memory_order_relaxed)){}
+	}
+}
+
+template<typename T>
+void RRT_star<T>::linkParent(const std::shared_ptr<TreeNode<T>> node,
+		const std::shared_ptr<TreeNode<T>> parent){
+	auto oldParent = node->getParent();
+	if(oldParent != nullptr){
+		oldParent->removeChild(node);
+	}
+	node->setParent(parent);
+	if(parent != nullptr){
+		parent->addChild(node);
+	}
+}
+
+// A rewire lowers the cost of a node by costDecrease, and the cost of each of
+// its descendants by the same amount, since their paths run through it
+template<typename T>
+void RRT_star<T>::propagateCost(const std::shared_ptr<TreeNode<T>> node,
+		const double costDecrease){
+	if(goalRegion->inObstacle(node->getItem())){
+		updateBestGoal(node);
+	}
+	propagationStack.clear();
+	propagationStack.push_back(node);
+	while(!propagationStack.empty()){
+		auto current = propagationStack.back();
+		propagationStack.pop_back();
+		for(const auto& weakChild : current->getChildren()){
+			auto child = weakChild.lock();
+			child->setCost(child->getCost() - costDecrease);
+			if(goalRegion->inObstacle(child->getItem())){
+				updateBestGoal(child);
+			}
+			propagationStack.push_back(child);
 		}
 	}
-	return TreeAncestorPath<T>(*bestGoalNode);
+}
+
+template<typename T>
+TreeAncestorPath<T> RRT_star<T>::getFinalPath(){
+	return TreeAncestorPath<T>(getBestGoalNode());
+}
+
+template<typename T>
+void RRT_star<T>::getFinalPath(std::vector<std::shared_ptr<TreeNode<T>>>& pathBuffer) const{
+	TreeAncestorPath<T>::extractAncestorPath(getBestGoalNode(), pathBuffer);
 }
 
 template<typename T>
@@ -372,3 +961,282 @@ void RRT_star<T>::printNodes(std::ofstream& os) const{
 		p_current_item->printItem(os);
 	}
 }
+
+template<typename T>
+void RRT_star<T>::serializeSnapshot(std::vector<char>& buffer) const{
+	SnapshotHeader header;
+	std::copy(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 8, header.magic);
+	header.N_nodes = nodeList.size();
+	header.N_goalNodes = goalNodes.size();
+	header.N_obstacles = env->getNumObstacles();
+	header.envDeltaX = env->getDeltaX();
+	header.envDeltaY = env->getDeltaY();
+	header.startX = start->getX();
+	header.startY = start->getY();
+	header.goalX = goalRegion->getX();
+	header.goalY = goalRegion->getY();
+	header.goalDX = goalRegion->getdx();
+	header.goalDY = goalRegion->getdy();
+
+	const std::size_t N = nodeList.size();
+	const std::size_t N_obstacles = env->getNumObstacles();
+	buffer.resize(sizeof(header) + 8 * (4 * N + goalNodes.size() + 4 * N_obstacles));
+	char* p = buffer.data();
+	std::memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	std::memcpy(p, nodeX.data(), 8 * N);
+	p += 8 * N;
+	std::memcpy(p, nodeY.data(), 8 * N);
+	p += 8 * N;
+	for(const auto& p_node : nodeList){
+		double cost = p_node->getCost();
+		std::memcpy(p, &cost, 8);
+		p += 8;
+	}
+	for(const auto& p_node : nodeList){
+		auto parent = p_node->getParent();
+		std::int64_t parentIndex = parent == nullptr ? -1 : std::int64_t(parent->getIndex());
+		std::memcpy(p, &parentIndex, 8);
+		p += 8;
+	}
+	for(const auto& p_node : goalNodes){
+		std::uint64_t goalIndex = p_node->getIndex();
+		std::memcpy(p, &goalIndex, 8);
+		p += 8;
+	}
+	for(std::size_t i = 0; i < N_obstacles; ++i){
+		double values[4] = {env->getObstacleX()[i], env->getObstacleY()[i],
+			env->getObstacleDX()[i], env->getObstacleDY()[i]};
+		std::memcpy(p, values, sizeof(values));
+		p += sizeof(values);
+	}
+}
+
+template<typename T>
+void RRT_star<T>::writeSnapshot(const std::string& filename) const{
+	std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+	if(!os.is_open()){
+		throw std::runtime_error("Unable to open " + filename);
+	}
+	std::vector<char> buffer;
+	serializeSnapshot(buffer);
+	os.write(buffer.data(), buffer.size());
+	if(!os.good()){
+		throw std::runtime_error("Error writing " + filename);
+	}
+}
+
+template<typename T>
+void RRT_star<T>::loadSnapshot(const std::string& filename){
+	MappedFile file(filename);
+	SnapshotView view(file);
+	const SnapshotHeader& header = view.getHeader();
+
+	auto newEnv = std::make_shared<Environment>(header.envDeltaX, header.envDeltaY);
+	newEnv->addObstacles(view.getObstacles(), header.N_obstacles);
+	newEnv->buildObstacleGrid();
+	env = newEnv;
+	distanceField = nullptr; // built from the previous environment
+	goalRegion = std::make_shared<Obstacle>(header.goalX, header.goalY,
+			header.goalDX, header.goalDY);
+	start = std::make_shared<T>(header.startX, header.startY);
+
+	// coordinates are copied straight out of the mapping, only the node
+	// objects have to be built one by one
+	const std::size_t N = header.N_nodes;
+	nodeX.reserve(std::max(N, storageCapacity()));
+	nodeY.reserve(std::max(N, storageCapacity()));
+	nodeX.assign(view.getX(), view.getX() + N);
+	nodeY.assign(view.getY(), view.getY() + N);
+	nodeList.clear();
+	nodeList.reserve(std::max(N, storageCapacity()));
+	const double* costs = view.getCost();
+	for(std::size_t i = 0; i < N; ++i){
+		auto p_node = std::make_shared<TreeNode<T>>(
+			std::make_shared<T>(nodeX[i], nodeY[i]));
+		p_node->setCost(costs[i]);
+		p_node->setIndex(i);
+		nodeList.push_back(p_node);
+	}
+	const std::int64_t* parents = view.getParent();
+	for(std::size_t i = 1; i < N; ++i){
+		linkParent(nodeList[i], nodeList[parents[i]]); // checked by SnapshotView
+	}
+	goalNodes.clear();
+	bestGoalNode = nullptr;
+	const std::uint64_t* goalIndices = view.getGoalNodes();
+	for(std::uint64_t i = 0; i < header.N_goalNodes; ++i){
+		goalNodes.push_back(nodeList[goalIndices[i]]);
+		updateBestGoal(goalNodes.back());
+	}
+	N_iterations = 0;
+	needFullCheckpoint = true;
+	checkpointEvents.clear();
+	streamRestart(); // readers replace the old tree with the loaded one
+	streamCatchUp();
+}
+
+template<typename T>
+void RRT_star<T>::recordCheckpointEvent(const char type,
+		const std::shared_ptr<TreeNode<T>> node){
+	if(checkpointWriter == nullptr || needFullCheckpoint){
+		return; // the next full checkpoint covers this event
+	}
+	CheckpointEvent event;
+	event.type = type;
+	event.index = node->getIndex();
+	auto parent = node->getParent();
+	event.parent = parent == nullptr ? -1 : std::int64_t(parent->getIndex());
+	event.x = nodeX[event.index];
+	event.y = nodeY[event.index];
+	event.cost = node->getCost();
+	checkpointEvents.push_back(event);
+}
+
+template<typename T>
+void RRT_star<T>::setCheckpointing(const std::string& prefix,
+		const std::uint64_t interval, const std::uint64_t deltasPerFull_in){
+	checkpointWriter = std::make_shared<CheckpointWriter>(prefix);
+	checkpointInterval = interval;
+	deltasPerFull = deltasPerFull_in;
+	deltasSinceFull = 0;
+	needFullCheckpoint = true;
+	checkpointEvents.clear();
+}
+
+template<typename T>
+void RRT_star<T>::checkpoint(){
+	if(checkpointWriter == nullptr || !checkpointWriter->isIdle()){
+		return; // events keep accumulating for the next checkpoint
+	}
+	std::vector<char> payload;
+	if(needFullCheckpoint || checkpointWriter->isFullRequired() ||
+			deltasSinceFull >= deltasPerFull){
+		// copying the tree out is the only O(N) part on the planning
+		// thread, the writer thread does the I/O
+		std::vector<char> snapshot;
+		serializeSnapshot(snapshot);
+		checkpointEvents.clear();
+		encodeCheckpointRecord(checkpointEvents, saveCheckpointState(), payload);
+		checkpointWriter->submitFull(std::move(snapshot), std::move(payload));
+		needFullCheckpoint = false;
+		deltasSinceFull = 0;
+	}
+	else{
+		encodeCheckpointRecord(checkpointEvents, saveCheckpointState(), payload);
+		checkpointEvents.clear();
+		checkpointWriter->submitDelta(std::move(payload));
+		++deltasSinceFull;
+	}
+}
+
+template<typename T>
+void RRT_star<T>::waitForCheckpoints(){
+	if(checkpointWriter != nullptr){
+		checkpointWriter->waitIdle();
+	}
+}
+
+template<typename T>
+std::string RRT_star<T>::saveCheckpointState(){
+	std::ostringstream os;
+	os << "RRTSTATE 2 " << N_iterations << ' ' << nodesSinceCompaction << ' '
+		<< gen << ' ';
+	stats.snapshot().save(os);
+	os << (sampleSource != nullptr) << ' ';
+	if(sampleSource != nullptr){
+		sampleSource->saveState(os);
+	}
+	return os.str();
+}
+
+template<typename T>
+void RRT_star<T>::loadCheckpointState(const std::string& state){
+	std::istringstream is(state);
+	std::string tag;
+	int version = 0;
+	is >> tag >> version;
+	if(tag != "RRTSTATE" || version != 2){
+		throw std::runtime_error("Unsupported checkpoint state");
+	}
+	RRT_stats savedStats;
+	bool hasSampleSource = false;
+	is >> N_iterations >> nodesSinceCompaction >> gen;
+	savedStats.load(is);
+	is >> hasSampleSource;
+	if(!is){
+		throw std::runtime_error("Invalid checkpoint state");
+	}
+	if(hasSampleSource != (sampleSource != nullptr)){
+		throw std::runtime_error("Checkpoint sample source does not match the planner's");
+	}
+	if(sampleSource != nullptr){
+		sampleSource->loadState(is);
+	}
+	stats.restore(savedStats);
+}
+
+template<typename T>
+void RRT_star<T>::replayCheckpointEvents(const std::vector<CheckpointEvent>& events){
+	// same operations, in the same order, as addNode/extend and iterate, so
+	// the costs and children lists come out exactly as in the original run;
+	// the goal test of a new node ran after its rewires
+	std::shared_ptr<TreeNode<T>> p_pendingGoal;
+	for(const auto& e : events){
+		if(e.parent < 0 || std::uint64_t(e.parent) >= nodeList.size()){
+			throw std::runtime_error("Checkpoint event parent out of range");
+		}
+		if(e.type == 'N'){
+			if(p_pendingGoal != nullptr){
+				addGoalCandidate(p_pendingGoal);
+			}
+			if(e.index != nodeList.size()){
+				throw std::runtime_error("Checkpoint node event out of order");
+			}
+			auto p_node = std::make_shared<TreeNode<T>>(
+				std::make_shared<T>(e.x, e.y), nodeList[e.parent]);
+			p_node->setCost(e.cost);
+			addNode(p_node);
+			p_pendingGoal = p_node;
+		}
+		else if(e.type == 'R'){
+			if(e.index >= nodeList.size()){
+				throw std::runtime_error("Checkpoint rewire event out of range");
+			}
+			auto p_node = nodeList[e.index];
+			double oldCost = p_node->getCost();
+			linkParent(p_node, nodeList[e.parent]);
+			p_node->setCost(e.cost);
+			propagateCost(p_node, oldCost - e.cost);
+		}
+		else{
+			throw std::runtime_error("Unknown checkpoint event");
+		}
+	}
+	if(p_pendingGoal != nullptr){
+		addGoalCandidate(p_pendingGoal);
+	}
+}
+
+template<typename T>
+void RRT_star<T>::resumeFromCheckpoint(const std::string& prefix){
+	std::uint64_t generation = CheckpointWriter::latestGeneration(prefix);
+	loadSnapshot(CheckpointWriter::snapshotName(prefix, generation));
+	std::vector<CheckpointEvent> events;
+	std::string state;
+	std::string lastState;
+	CheckpointWriter::readLog(CheckpointWriter::logName(prefix, generation),
+		[&](const char* payload, std::size_t size){
+			decodeCheckpointRecord(payload, size, events, state);
+			replayCheckpointEvents(events);
+			lastState.swap(state);
+		});
+	if(lastState.empty()){
+		throw std::runtime_error("Checkpoint log has no complete record");
+	}
+	loadCheckpointState(lastState);
+	needFullCheckpoint = true;
+	checkpointEvents.clear();
+	streamRestart(); // the replayed rewires were not streamed
+	streamCatchUp();
+}
@@ -4,6 +4,15 @@
 #include "tree_classes.h"
 #include "tree_classes.cpp"
 #include "environment_classes.h"
+#include "distance_kernels.h"
+#include "rrt_stats.h"
+#include "snapshot_format.h"
+#include "tree_stream.h"
+#include "sample_sources.h"
+#include "cost_metrics.h"
+#include "checkpoint.h"
+#include "distance_field.h"
+#include <random>
 
 // RRT* algorithm, formulated as a template class definition
 // RRT* constructor initializes algorithm calculation
@@ -16,24 +25,91 @@
 // that returns the distance between the item and the item that the input
 // pointer points to
 // 2) Can be tested to see if it falls in an Obstacle
-// 3) has a genRandom() member function that generates random parameters
+// 3) has a genRandom(const Environment&, std::mt19937&) member function that
+// generates random parameters
 // 4) A Line can connect two instances of T
+// 5) has getX() and getY() member functions, the coordinates are mirrored
+// into contiguous arrays for the nearest/near node searches
+// 6) can be constructed from its coordinates, T(x,y) (snapshot loading,
+// sample sources)
 //
 // Log:
 // 3/20/19: Initial creation
+// Nearest/near node searches use the batch kernels in distance_kernels.h
+// Optional hot-path counters and timers, see rrt_stats.h
+// Pluggable sample sequences, see sample_sources.h
+// Pluggable edge cost metric and cost-to-go heuristic, see cost_metrics.h
+// Asynchronous incremental checkpoints, see checkpoint.h
+// Optional clearance field to skip exact edge checks, see distance_field.h
 template<typename T>
 class RRT_star{
 	protected:
 		int N_points = 1; // Number of points to sample successfully
 		std::vector<std::shared_ptr<TreeNode<T>>> nodeList;
-		std::shared_ptr<Environment> env; // Environment to apply RRT* algorithm
+		// Coordinates of the items in nodeList, same order, kept as
+		// contiguous arrays for the batch distance kernels
+		std::vector<double> nodeX;
+		std::vector<double> nodeY;
+		std::shared_ptr<const Environment> env; // Environment to apply RRT* algorithm, read only (may be shared between planners)
 		std::shared_ptr<Obstacle> goalRegion; // Goal region
 		std::shared_ptr<T> start; // Start/root of the tree
 
 		std::vector<std::shared_ptr<TreeNode<T>>> goalNodes;
+		// Lowest cost node of goalNodes, updated when a goal node is added or
+		// its cost drops through a rewire (costs never increase)
+		std::shared_ptr<TreeNode<T>> bestGoalNode;
+		std::function<void(double, std::shared_ptr<TreeNode<T>>)> bestCostCallback;
+		std::vector<std::shared_ptr<TreeNode<T>>> propagationStack; // scratch space of propagateCost
+		// Best path cost known to a group of planners (see ParallelRRT_star);
+		// when set, new nodes that cannot beat it are not added
+		std::shared_ptr<std::atomic<double>> sharedCostBound;
+
+		std::mt19937 gen{std::random_device{}()}; // sampling generator, see setSeed
+		std::shared_ptr<SampleSource> sampleSource; // replaces T::genRandom when set, see setSampleSource
+		bool rejectOccupiedSamples = true; // redraw samples that fall inside an obstacle
+		int maxSampleAttempts = 64; // draws per extend before it gives up
+		RRT_statCounters stats; // only written when RRT_ENABLE_STATS is defined, see rrt_stats.h
+		std::shared_ptr<TreeStreamSink> streamSink; // optional live export, see setStreamSink
+		// nodes [0, streamSentNodes) are in the reader's copy of the tree:
+		// their events are streamed, the others are sent by streamCatchUp
+		std::size_t streamSentNodes = 0;
+		bool streamClearPending = false; // 'C' still has to be sent, see streamRestart
+		std::shared_ptr<const DistanceField> distanceField; // optional, see setDistanceField
+		EdgeCostFunction<T> edgeCost; // empty: T::calculateCost, see setEdgeCost
+		bool symmetricEdgeCost = true;
+		CostToGoFunction<T> costToGo; // empty: no heuristic, see setCostToGo
+
+		// Scratch buffers of extend, reused every iteration (no allocation
+		// once they have grown to the largest near node set). Entry k of
+		// the near* buffers belongs to near node nodeList[nearIndices[k]].
+		std::vector<std::size_t> nearIndices;
+		std::vector<double> nearDistSq; // squared distance to the new item
+		std::vector<double> nearEdgeCost; // edge cost between near node and new item
+		std::vector<double> nearPathCost; // cost to reach the new item through the near node
+		std::vector<std::uint32_t> candidateOrder; // near node entries by nearPathCost
+		std::vector<char> nearCollision; // 0 not checked, 1 free, 2 blocked
+		static const int N_nearTasks = 8; // tasks of the parallel near search (large trees)
+		std::vector<std::vector<std::size_t>> taskIndices; // parallel near search, per task
+		std::vector<std::vector<double>> taskDistSq;
+
+		std::uint64_t N_iterations = 0; // iterate calls since the tree was started or loaded
+		std::shared_ptr<CheckpointWriter> checkpointWriter; // see setCheckpointing
+		std::uint64_t checkpointInterval = 0; // iterations between checkpoints
+		std::uint64_t deltasPerFull = 64; // delta checkpoints between full ones
+		std::uint64_t deltasSinceFull = 0;
+		// set when the tree changed in a way the event log does not cover
+		// (compaction, eviction, loading), the next checkpoint is full
+		bool needFullCheckpoint = true;
+		std::vector<CheckpointEvent> checkpointEvents; // tree events since the last checkpoint
+		std::size_t compactionInterval = 0; // nodes added between compactTree calls, 0 = never
+		std::size_t nodesSinceCompaction = 0;
+		std::size_t memoryBudget = 0; // bytes, 0 = unbounded, see setMemoryBudget
+		std::size_t maxNodes = 0; // node cap derived from memoryBudget, 0 = none
+		int evictionSamples = 16; // random nodes examined per eviction
 
 		// Internal member functions
 		bool extend(const double radius); // return value indicates whether or not extend succeeded (obstacle free, new node added)
+		std::shared_ptr<T> sample(); // random item from sampleSource, or T::genRandom
 		bool collisionCheck(std::shared_ptr<T> p1,
 				std::shared_ptr<T> p2); // indicates whether or not the path between p1 and p2 has a collision (0 = no collision)
 
@@ -43,24 +119,59 @@ class RRT_star{
 		std::shared_ptr<TreeNode<T>> getNearestNode_single(
 			const std::shared_ptr<T> p_proposedItem) const;
 
-		std::pair<double,std::shared_ptr<TreeNode<T>>> getNearestNode_worker(
+		std::pair<double,std::size_t> getNearestNode_worker(
 				const std::shared_ptr<T> p_proposedItem,
-				const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_i,
-				const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_i) const;
+				const std::size_t start_i,
+				const std::size_t end_i) const; // nearest node index (and squared distance) within [start_i,end_i) of nodeList
 
-		std::vector<std::shared_ptr<TreeNode<T>>> getNearNodesParallel(
-			const std::shared_ptr<T> p_node, const double radius);
+		// near node searches write the nodes within radius of p_node (and
+		// their squared distances) to nearIndices and nearDistSq
+		void getNearNodesParallel(const std::shared_ptr<T> p_node,
+				const double radius);
 
-		std::vector<std::shared_ptr<TreeNode<T>>>
-			getNearNodes_single(const std::shared_ptr<T> p_node,
-				     const double radius) const; // returns all nodes within a set radius of the node pointed to by p_node
+		void getNearNodes_single(const std::shared_ptr<T> p_node,
+				const double radius);
 
-	 std::vector<std::shared_ptr<TreeNode<T>>> getNearNodes_worker(const std::shared_ptr<T> p_node,
-			const double radius, const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator start_it,
-			const typename std::vector<std::shared_ptr<TreeNode<T>>>::const_iterator end_it) const;
+	 void getNearNodes_worker(const std::shared_ptr<T> p_node,
+			const double radius, const std::size_t start_i,
+			const std::size_t end_i, std::vector<std::size_t>& indices,
+			std::vector<double>& distSq) const; // indices of nodeList within [start_i,end_i) inside the radius
 
 	 double calculateCost(const std::shared_ptr<TreeNode<T>>
 				node) const; // calculate the cost betweensome node and its parent
+	 double calculateEdgeCost(const std::shared_ptr<T> parentItem,
+			const std::shared_ptr<T> childItem) const; // cost of an edge under the edge cost metric
+
+	 std::shared_ptr<TreeNode<T>> getBestGoalNode() const; // lowest cost node in goalNodes
+
+	 void linkParent(const std::shared_ptr<TreeNode<T>> node,
+			const std::shared_ptr<TreeNode<T>> parent); // sets the parent and moves node to the parent's children
+	 void propagateCost(const std::shared_ptr<TreeNode<T>> node,
+			const double costDecrease); // lowers the cost of all descendants of node after a rewire
+	 void updateBestGoal(const std::shared_ptr<TreeNode<T>> goalNode); // goalNode was added or got cheaper
+
+	 void streamEvent(const char type,
+			const std::shared_ptr<TreeNode<T>> node); // pushes a node event to streamSink, if the reader has the node
+	 void streamRemoval(const std::size_t index); // pushes a 'D' event, if the reader has the node
+	 void streamRestart(); // the reader's tree is wrong or stale: 'C' and every node are sent again
+	 void streamCatchUp(); // sends a pending 'C' and unsent nodes while half of the ring is free
+	 void recordCheckpointEvent(const char type,
+			const std::shared_ptr<TreeNode<T>> node); // adds a node event to the next checkpoint
+	 void addGoalCandidate(const std::shared_ptr<TreeNode<T>> node); // adds node to goalNodes if it is in goalRegion
+	 void serializeSnapshot(std::vector<char>& buffer) const; // snapshot file contents, see writeSnapshot
+	 std::string saveCheckpointState(); // iterations, generator, sample source and counters as text
+	 void loadCheckpointState(const std::string& state);
+	 void replayCheckpointEvents(const std::vector<CheckpointEvent>& events);
+
+	 static std::size_t nodeObjectBytes(); // heap bytes of one node and its item
+	 static std::size_t bytesPerNode(); // nodeObjectBytes plus the node's storage entries
+	 std::size_t storageCapacity() const; // nodes to reserve storage for
+	 void reserveStorage(const std::size_t capacity); // (re)sizes the node storage capacity
+	 bool evictNode(); // removes the worst of a few random leaves, false if every leaf is protected
+
+	 // 32 bit Morton (Z-order) code of (x,y), coordinates quantized to 16 bits
+	 // over the Environment
+	 std::uint32_t mortonCode(const double x, const double y) const;
 
 	 std::shared_ptr<T> steer(const
 			std::shared_ptr<TreeNode<T>> p_nearestNode,
@@ -70,12 +181,94 @@ class RRT_star{
 		// constructor, initializes algorithm
 		RRT_star(int N, Environment& env_input, Obstacle& goal_in,
 				T& start_in);
+		// shares env_input instead of copying it, build its obstacle grid
+		// first (Environment::buildObstacleGrid) for fast collision checks
+		RRT_star(int N, std::shared_ptr<const Environment> env_input,
+				Obstacle& goal_in, T& start_in);
 
 		// Public Member functions
 		void addNode(std::shared_ptr<TreeNode<T>> newNode);
+		// Streams node additions and rewires to sink while the planner runs
+		// (nodes already in the tree are sent first), nullptr detaches it
+		void setStreamSink(std::shared_ptr<TreeStreamSink> sink);
 
-		void initiate(double radius); //initiate RRT calculation
+		void setSeed(unsigned int seed); // makes the sampled sequence reproducible
+		// Draws samples from source (scaled from the unit square to the
+		// Environment) instead of T::genRandom, nullptr restores genRandom
+		void setSampleSource(std::shared_ptr<SampleSource> source);
+		// Samples inside an obstacle are redrawn (up to maxAttempts draws per
+		// extend) before the nearest node search, on by default
+		void setRejectOccupiedSamples(const bool reject, const int maxAttempts = 64);
+		// Shares a best cost bound with other planners: the planner lowers it
+		// when it finds a better path and prunes new nodes whose cost to come
+		// is not below it
+		void setSharedCostBound(std::shared_ptr<std::atomic<double>> bound);
+		// Accepts edges that the field proves obstacle free without the exact
+		// segment test (far from every obstacle), the others are checked
+		// exactly as before; nullptr turns it off. The field has to be built
+		// from the planner's Environment, after all obstacles were added.
+		void setDistanceField(std::shared_ptr<const DistanceField> field);
+		void initiate(double radius); //initiate RRT calculation, runs iterate until N_points-1 iterations were done since the tree was started (or loaded)
+		std::uint64_t getIterations() const; // iterate calls so far
+		// Reorders the tree storage along a Morton curve so that nodes close
+		// in space are close in memory (nodeList, coordinate arrays, and the
+		// node and item objects, which are reallocated in the new order).
+		// With a memory budget the node objects are kept and only the
+		// storage is reordered, in place, so the footprint stays within the
+		// budget. The root stays at index 0, node indices change, paths taken
+		// before the call keep referring to the old node objects. Streams a
+		// 'C' event followed by every node when a sink is attached.
+		void compactTree();
+		// calls compactTree every interval added nodes (from iterate), 0 = never
+		void setCompactionInterval(const std::size_t interval);
+		// Edge cost metric (cost of the edge from a parent item to a child
+		// item, e.g. euclideanLengthCost), empty restores T::calculateCost.
+		// Set before the tree is grown. Edge costs are computed once per
+		// near node and reused by the rewire step, which requires the
+		// metric to be symmetric; pass symmetric = false otherwise.
+		void setEdgeCost(EdgeCostFunction<T> cost, const bool symmetric = true);
+		// Admissible cost-to-go toward goalRegion under the edge cost metric
+		// (e.g. regionDistanceCostToGo). Once a path is found, new nodes
+		// whose cost to come plus cost-to-go cannot beat it are not added
+		// (also against the shared bound of setSharedCostBound).
+		void setCostToGo(CostToGoFunction<T> heuristic);
+		// Caps the memory of the tree (nodes, items, coordinate arrays, goal
+		// list, near search and propagation scratch) at about bytes,
+		// 0 = unbounded (default). All of this storage is reserved once at
+		// the cap. Once the tree reaches it, the planner runs in bounded
+		// mode: every node added evicts the highest cost leaf among a few
+		// random ones (never the root or the end of the best path; evicted
+		// goal nodes leave the goal list), so the tree keeps improving at a
+		// fixed footprint. Eviction moves the last node into the free slot,
+		// so node indices change. iterate throws std::runtime_error if the
+		// cap cannot be held (every leaf is protected).
+		void setMemoryBudget(const std::size_t bytes);
+		std::size_t getMemoryUsage() const; // estimated bytes used by the tree
+		void setCheckpointing(const std::string& prefix, const std::uint64_t interval, const std::uint64_t deltasPerFull_in = 64); // background checkpoints every interval iterations, see checkpoint.h
+		void checkpoint(); // checkpoint now (skipped while the writer is busy)
+		void waitForCheckpoints(); // blocks until the submitted checkpoints are on disk
+		void resumeFromCheckpoint(const std::string& prefix); // restore the latest checkpoint under prefix (as loadSnapshot), set the same sample source and costs first
+		std::size_t getMaxNodes() const; // node cap of the memory budget, 0 = none
+		int getNumPoints() const; // number of points to sample, N
+		void initializeTree(); // check assumptions and add the start node, first part of initiate
+		bool iterate(double radius); // one extend step of initiate, returns whether a node was added
+		RRT_stats getStats() const; // counters and cycles per phase so far, safe to call during a run
+		bool pathFound() const; // whether any node reached the goal region
+		double getBestCost() const; // cost of the best path so far (O(1)), infinity if no path was found
+		// callback(cost, goalNode) runs on the planning thread every time the
+		// best path cost improves
+		void setBestCostCallback(std::function<void(double,
+				std::shared_ptr<TreeNode<T>>)> callback);
 		TreeAncestorPath<T> getFinalPath(); // get path resulting from RRT* calculation, if multiple paths exist, choose the best one
+		void getFinalPath(std::vector<std::shared_ptr<TreeNode<T>>>& pathBuffer) const; // same path written into a caller supplied buffer, no allocation once the buffer is large enough
 		void printNodes(std::ofstream& os) const;
+
+		// Binary snapshots of the tree, Environment and goal set, see
+		// snapshot_format.h. loadSnapshot replaces the current state so that
+		// initiate/iterate continue from the loaded tree (warm start); it
+		// detaches the distance field (set one built from the loaded
+		// Environment again) and resends the tree to an attached stream.
+		void writeSnapshot(const std::string& filename) const;
+		void loadSnapshot(const std::string& filename);
 };
 #endif
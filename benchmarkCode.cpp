@@ -0,0 +1,321 @@
+#define RRT_ENABLE_STATS // phase timers and counters, see rrt_stats.h
+#include "std_lib_facilities.h"
+#include "environment_classes.h"
+
+#include "tree_classes.h"
+#include "tree_classes.cpp"
+#include "RRT_classes.h"
+#include "RRT_classes.cpp"
+#include <chrono>
+#include <deque>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Benchmark suite for RRT_star on reproducible, seeded scenarios
+// Each scenario is a square map with randomly placed obstacles, a start at
+// (1,1) and a goal region in the top right corner. Maps and samples are drawn
+// from generators seeded with the scenario seed, so a scenario is the same on
+// every run of a given build. std::mt19937 is fully specified, but
+// std::uniform_real_distribution is not, so builds with a different standard
+// library may draw different maps. Maps without an obstacle free route from
+// the start to the goal region are redrawn, so every scenario is solvable.
+// Each scenario runs in a child process, which makes its peak RSS its own.
+// Results are written as CSV (one row per scenario and repetition) to the file
+// given as the first argument, or to stdout. The second argument sets the
+// number of repetitions (seeds) per scenario, default 3. The optional third
+// argument picks the sample source: genRandom (default), uniform, halton,
+// sobol, stratified, or any of these prefixed with buffered- (see
+// sample_sources.h). The optional fourth argument sets the tree compaction
+// interval in nodes (RRT_star::setCompactionInterval), default 0 (off). The
+// optional fifth argument sets the cell size of a distance field used to
+// skip exact collision checks (RRT_star::setDistanceField), 0 picks the
+// default cell size and no argument (or a negative size) leaves it off.
+//
+// Log:
+// Initial creation
+
+struct Scenario{
+	double mapSize;
+	int N_obstacles;
+	int N_samples;
+	double radius;
+};
+
+// Percentile of the (unsorted) latency list, p in [0,1]
+double percentile(std::vector<double> values, const double p){
+	if(values.empty()){return 0;}
+	std::size_t k = std::size_t(p * (values.size() - 1));
+	std::nth_element(values.begin(), values.begin() + k, values.end());
+	return values[k];
+}
+
+// Rate of readCycleCounter, used to convert the RRT_stats phase cycles to seconds
+double cyclesPerSecond(){
+	auto wallStart = std::chrono::steady_clock::now();
+	std::uint64_t cycleStart = readCycleCounter();
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	std::uint64_t cycles = readCycleCounter() - cycleStart;
+	double seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - wallStart).count();
+	return double(cycles) / seconds;
+}
+
+// True if an obstacle free route leads from start into the goal region:
+// breadth first search over the cells of a 256x256 raster whose clearance
+// (see DistanceField) covers the whole cell, neighbouring such cells are
+// joined by a free straight segment
+bool routeExists(const Environment& env, const Point& start, const Obstacle& goal){
+	DistanceField field(env, std::max(env.getDeltaX(), env.getDeltaY()) / 256);
+	const double h = field.getCellSize();
+	const int N_x = field.getNumCellsX();
+	const int N_y = field.getNumCellsY();
+	auto cellFree = [&](const int cx, const int cy){
+		return field.getClearance((cx + 0.5) * h, (cy + 0.5) * h) > h;
+	};
+	int startX = std::min(int(start.getX() / h), N_x - 1);
+	int startY = std::min(int(start.getY() / h), N_y - 1);
+	if(!cellFree(startX, startY)){
+		return false;
+	}
+	std::vector<char> visited(std::size_t(N_x) * N_y, 0);
+	std::deque<std::pair<int, int>> queue{{startX, startY}};
+	visited[std::size_t(startY) * N_x + startX] = 1;
+	const int steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+	while(!queue.empty()){
+		int cx = queue.front().first;
+		int cy = queue.front().second;
+		queue.pop_front();
+		// goal region spans [x, x+dx] by [y-dy, y]
+		double px = (cx + 0.5) * h;
+		double py = (cy + 0.5) * h;
+		if(px >= goal.getX() && px <= goal.getX() + goal.getdx() &&
+				py <= goal.getY() && py >= goal.getY() - goal.getdy()){
+			return true;
+		}
+		for(const auto& step : steps){
+			int nx = cx + step[0];
+			int ny = cy + step[1];
+			if(nx < 0 || ny < 0 || nx >= N_x || ny >= N_y ||
+					visited[std::size_t(ny) * N_x + nx] || !cellFree(nx, ny)){
+				continue;
+			}
+			visited[std::size_t(ny) * N_x + nx] = 1;
+			queue.push_back({nx, ny});
+		}
+	}
+	return false;
+}
+
+// Peak RSS of this process; runScenario runs in a fresh child process
+// (see main), so this is the peak of one scenario plus the small footprint
+// of the parent at the fork
+long peakRSS_kB(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss; // kilobytes on Linux
+}
+
+// Sample source by name, nullptr for T::genRandom
+std::shared_ptr<SampleSource> makeSampleSource(const std::string& name,
+		const unsigned int seed){
+	if(name.compare(0, 9, "buffered-") == 0){
+		return std::make_shared<BufferedSampleSource>(
+				makeSampleSource(name.substr(9), seed));
+	}
+	if(name == "uniform"){
+		return std::make_shared<UniformSampleSource>(seed);
+	}
+	if(name == "halton"){
+		return std::make_shared<HaltonSampleSource>(seed);
+	}
+	if(name == "sobol"){
+		return std::make_shared<SobolSampleSource>(seed);
+	}
+	if(name == "stratified"){
+		return std::make_shared<StratifiedSampleSource>(32, 32, seed);
+	}
+	if(name != "genRandom"){
+		throw std::runtime_error("Unknown sample source " + name);
+	}
+	return nullptr;
+}
+
+void runScenario(const Scenario& sc, const unsigned int seed,
+		const std::string& sampler, const std::size_t compactionInterval,
+		const double fieldCellSize,
+		const double cycleRate, std::ostream& os){
+	std::mt19937 mapGen(seed);
+	Point start_point(1.0, 1.0);
+	Obstacle goal_region(0.86 * sc.mapSize, 0.98 * sc.mapSize,
+			0.14 * sc.mapSize, 0.04 * sc.mapSize);
+	// obstacles covering the start or the goal corner are redrawn, then
+	// maps without a route to the goal (mapGen carries on, so the redrawn
+	// map is still determined by the seed)
+	auto p_start = std::make_shared<Point>(start_point);
+	auto p_goal = std::make_shared<Point>(goal_region.getX() + goal_region.getdx(),
+			goal_region.getY());
+	Environment env(sc.mapSize, sc.mapSize);
+	for(int attempt = 0; ; ++attempt){
+		if(attempt == 1000){
+			throw std::runtime_error("No solvable map for scenario");
+		}
+		env = Environment(sc.mapSize, sc.mapSize);
+		int N_placed = 0;
+		while(N_placed < sc.N_obstacles){
+			auto newOb = std::make_shared<Obstacle>();
+			newOb->genRandom(sc.mapSize, sc.mapSize, 0.05 * sc.mapSize, mapGen);
+			if(!newOb->inObstacle(p_start) && !newOb->inObstacle(p_goal)){
+				env.addObstacle(newOb);
+				++N_placed;
+			}
+		}
+		if(routeExists(env, start_point, goal_region)){
+			break;
+		}
+	}
+
+	RRT_star<Point> rrtObject(sc.N_samples, env, goal_region, start_point);
+	rrtObject.setSeed(seed);
+	rrtObject.setSampleSource(makeSampleSource(sampler, seed));
+	rrtObject.setCompactionInterval(compactionInterval);
+	if(fieldCellSize >= 0){
+		rrtObject.setDistanceField(std::make_shared<DistanceField>(env, fieldCellSize));
+	}
+
+	std::vector<double> latencies;
+	latencies.reserve(sc.N_samples);
+	int N_added = 0;
+	auto runStart = std::chrono::steady_clock::now();
+	rrtObject.initializeTree();
+	for(int i = 1; i < sc.N_samples; ++i){
+		auto iterStart = std::chrono::steady_clock::now();
+		N_added += rrtObject.iterate(sc.radius);
+		auto iterStop = std::chrono::steady_clock::now();
+		latencies.push_back(std::chrono::duration<double, std::micro>(
+					iterStop - iterStart).count());
+	}
+	double runSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - runStart).count();
+
+	// path extraction, only possible when the goal region was reached
+	// (the column stays empty otherwise)
+	bool goalReached = rrtObject.pathFound();
+	std::ostringstream pathSeconds;
+	std::size_t pathLength = 0;
+	if(goalReached){
+		auto pathStart = std::chrono::steady_clock::now();
+		TreeAncestorPath<Point> finalPath = rrtObject.getFinalPath();
+		pathSeconds << std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - pathStart).count();
+		pathLength = finalPath.getPath().size();
+	}
+
+	RRT_stats stats = rrtObject.getStats();
+	os << sc.mapSize << "," << sc.N_obstacles << "," << sc.N_samples << ","
+		<< sc.radius << "," << seed << "," << sampler << ","
+		<< N_added << "," << goalReached << "," << pathLength << ","
+		<< rrtObject.getBestCost() << ","
+		<< runSeconds << "," << (sc.N_samples - 1) / runSeconds << ","
+		<< percentile(latencies, 0.5) << "," << percentile(latencies, 0.99) << ","
+		<< stats.samplingCycles / cycleRate << ","
+		<< stats.nearestCycles / cycleRate << ","
+		<< stats.nearCycles / cycleRate << ","
+		<< stats.collisionCycles / cycleRate << ","
+		<< stats.parentSelectionCycles / cycleRate << ","
+		<< stats.rewireCycles / cycleRate << "," << pathSeconds.str() << ","
+		<< stats.collisionChecks << "," << stats.obstacleTests << ","
+		<< (stats.nearQueries ? double(stats.nearNodesTotal) / stats.nearQueries : 0.0) << ","
+		<< stats.nearNodesMax << "," << stats.rewires << ","
+		<< stats.rejectedSamples << "," << stats.clearanceAccepts << ","
+		<< peakRSS_kB() << "\n";
+	os.flush();
+}
+
+int main(int argc, char* argv[])
+{
+	std::ofstream outFile;
+	if(argc > 1){
+		outFile.open(argv[1]);
+		if(!outFile.is_open()){
+			std::cerr << "Unable to open benchmark output file" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& os = argc > 1 ? outFile : std::cout;
+	int N_repetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+	std::string sampler = argc > 3 ? argv[3] : "genRandom";
+	std::size_t compactionInterval = argc > 4 ? std::stoul(argv[4]) : 0;
+	double fieldCellSize = argc > 5 ? std::stod(argv[5]) : -1;
+	double cycleRate = cyclesPerSecond();
+
+	std::vector<Scenario> scenarios;
+	for(double mapSize : {50.0, 200.0}){
+		// steering moves at most 0.5 per node, so the tree needs more nodes
+		// to reach the far goal corner on the larger map; these N reach it
+		// on every map of the default seeds
+		std::vector<int> sampleCounts = mapSize < 100 ? std::vector<int>{10000, 20000}
+			: std::vector<int>{40000, 60000};
+		// denser maps (about 600 obstacles and up) are almost never
+		// connected and would be redrawn forever
+		for(int N_obstacles : {0, 150, 400}){
+			for(int N_samples : sampleCounts){
+				for(double radius : {2.0, 4.0}){
+					scenarios.push_back(Scenario{mapSize, N_obstacles,
+							N_samples, radius});
+				}
+			}
+		}
+	}
+
+	// the phase columns are totals over the run in seconds, latencies are
+	// per iteration in microseconds and peak RSS is per scenario.
+	// iterations_per_s counts extend steps; samples redrawn inside
+	// obstacles are in rejected_samples
+	os << "map_size,obstacles,N,radius,seed,sampler,nodes_added,goal_reached,"
+		<< "path_nodes,best_cost,"
+		<< "total_s,iterations_per_s,median_us,p99_us,"
+		<< "sampling_s,nearest_s,near_s,collision_s,parent_selection_s,"
+		<< "rewire_s,path_extraction_s,collision_checks,obstacle_tests,"
+		<< "near_mean,near_max,rewires,rejected_samples,"
+		<< "clearance_accepts,peak_rss_kB\n";
+	for(const auto& sc : scenarios){
+		for(int rep = 0; rep < N_repetitions; ++rep){
+			// one child process per scenario, so that peak RSS is per
+			// scenario (getrusage only reports the high-water mark of the
+			// whole process). The child shares the output file and its
+			// offset, the flush keeps the parent's buffer out of the child.
+			os.flush();
+			pid_t pid = fork();
+			if(pid == 0){
+				int exitCode = 0;
+				try{
+					runScenario(sc, 1000u + rep, sampler, compactionInterval,
+							fieldCellSize, cycleRate, os);
+				}
+				catch(const std::exception& e){
+					std::cerr << "Scenario failed: " << e.what() << std::endl;
+					exitCode = 1;
+				}
+				os.flush();
+				_exit(exitCode);
+			}
+			if(pid < 0){
+				std::cerr << "fork failed, running the scenario in process" << std::endl;
+				runScenario(sc, 1000u + rep, sampler, compactionInterval,
+						fieldCellSize, cycleRate, os);
+				continue;
+			}
+			int status = 0;
+			waitpid(pid, &status, 0);
+			if(!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+				std::cerr << "Scenario " << sc.mapSize << "/" << sc.N_obstacles
+					<< "/" << sc.N_samples << "/" << sc.radius << " seed "
+					<< 1000u + rep << " did not finish" << std::endl;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,290 @@
+#include "checkpoint.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+std::uint64_t checkpointChecksum(const char* data, const std::size_t size){
+	std::uint64_t hash = 14695981039346656037ull;
+	for(std::size_t i = 0; i < size; ++i){
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void encodeCheckpointRecord(const std::vector<CheckpointEvent>& events,
+		const std::string& state, std::vector<char>& payload){
+	std::uint64_t N_events = events.size();
+	std::uint64_t stateBytes = state.size();
+	payload.resize(16 + N_events * sizeof(CheckpointEvent) + stateBytes);
+	char* p = payload.data();
+	std::memcpy(p, &N_events, 8);
+	p += 8;
+	if(N_events > 0){
+		std::memcpy(p, events.data(), N_events * sizeof(CheckpointEvent));
+	}
+	p += N_events * sizeof(CheckpointEvent);
+	std::memcpy(p, &stateBytes, 8);
+	p += 8;
+	std::memcpy(p, state.data(), stateBytes);
+}
+
+void decodeCheckpointRecord(const char* payload, const std::size_t size,
+		std::vector<CheckpointEvent>& events, std::string& state){
+	std::uint64_t N_events = 0;
+	std::uint64_t stateBytes = 0;
+	if(size < 16){
+		throw std::runtime_error("Checkpoint record too small");
+	}
+	std::memcpy(&N_events, payload, 8);
+	if(N_events > (size - 16) / sizeof(CheckpointEvent)){
+		throw std::runtime_error("Checkpoint record events out of range");
+	}
+	const char* p = payload + 8;
+	events.resize(N_events);
+	if(N_events > 0){
+		std::memcpy(events.data(), p, N_events * sizeof(CheckpointEvent));
+	}
+	p += N_events * sizeof(CheckpointEvent);
+	std::memcpy(&stateBytes, p, 8);
+	p += 8;
+	if(stateBytes != size - 16 - N_events * sizeof(CheckpointEvent)){
+		throw std::runtime_error("Checkpoint record size does not match its contents");
+	}
+	state.assign(p, stateBytes);
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& prefix_in){
+	prefix = prefix_in;
+	try{
+		generation = latestGeneration(prefix);
+	}
+	catch(const std::runtime_error&){
+		generation = 0; // no checkpoint yet
+	}
+	writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	writer.join();
+	if(log != nullptr){
+		std::fclose(log);
+	}
+}
+
+void CheckpointWriter::submitFull(std::vector<char> snapshot, std::vector<char> payload){
+	Job job;
+	job.full = true;
+	job.snapshot.swap(snapshot);
+	job.payload.swap(payload);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	wake.notify_one();
+}
+
+void CheckpointWriter::submitDelta(std::vector<char> payload){
+	Job job;
+	job.payload.swap(payload);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	wake.notify_one();
+}
+
+bool CheckpointWriter::isIdle(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.empty() && !busy;
+}
+
+bool CheckpointWriter::isFullRequired(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return fullRequired;
+}
+
+void CheckpointWriter::waitIdle(){
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this](){return jobs.empty() && !busy;});
+}
+
+std::uint64_t CheckpointWriter::getWritten(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return N_written;
+}
+
+std::string CheckpointWriter::getLastError(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return lastError;
+}
+
+std::string CheckpointWriter::manifestName(const std::string& prefix){
+	return prefix + ".ckpt";
+}
+
+std::string CheckpointWriter::snapshotName(const std::string& prefix,
+		const std::uint64_t generation){
+	return prefix + "." + std::to_string(generation) + ".rrtsnap";
+}
+
+std::string CheckpointWriter::logName(const std::string& prefix,
+		const std::uint64_t generation){
+	return prefix + "." + std::to_string(generation) + ".rrtlog";
+}
+
+std::uint64_t CheckpointWriter::latestGeneration(const std::string& prefix){
+	std::ifstream is(manifestName(prefix));
+	std::uint64_t generation = 0;
+	if(!(is >> generation)){
+		throw std::runtime_error("No checkpoint manifest " + manifestName(prefix));
+	}
+	return generation;
+}
+
+void CheckpointWriter::readLog(const std::string& filename,
+		const std::function<void(const char*, std::size_t)>& onRecord){
+	MappedFile file(filename);
+	std::size_t position = 0;
+	while(position + sizeof(CheckpointRecordHeader) <= file.size()){
+		CheckpointRecordHeader header;
+		std::memcpy(&header, file.data() + position, sizeof(header));
+		position += sizeof(header);
+		if(std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+				header.payloadBytes > file.size() - position ||
+				checkpointChecksum(file.data() + position, header.payloadBytes)
+					!= header.checksum){
+			return; // cut short by a crash
+		}
+		onRecord(file.data() + position, header.payloadBytes);
+		position += header.payloadBytes;
+	}
+}
+
+void CheckpointWriter::appendRecord(std::FILE* os, const std::vector<char>& payload){
+	CheckpointRecordHeader header;
+	std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	header.payloadBytes = payload.size();
+	header.checksum = checkpointChecksum(payload.data(), payload.size());
+	if(std::fwrite(&header, sizeof(header), 1, os) != 1 ||
+			std::fwrite(payload.data(), 1, payload.size(), os) != payload.size() ||
+			std::fflush(os) != 0 || fsync(fileno(os)) != 0){
+		throw std::runtime_error("Error writing checkpoint record");
+	}
+}
+
+// writes filename through a temporary file, so that filename is either the
+// old or the complete new file
+static void writeFileAtomic(const std::string& filename, const char* data,
+		const std::size_t size){
+	std::string tmpName = filename + ".tmp";
+	std::FILE* os = std::fopen(tmpName.c_str(), "wb");
+	if(os == nullptr){
+		throw std::runtime_error("Unable to open " + tmpName);
+	}
+	bool ok = std::fwrite(data, 1, size, os) == size && std::fflush(os) == 0
+		&& fsync(fileno(os)) == 0;
+	ok = std::fclose(os) == 0 && ok;
+	if(!ok || std::rename(tmpName.c_str(), filename.c_str()) != 0){
+		throw std::runtime_error("Error writing " + filename);
+	}
+}
+
+void CheckpointWriter::writeFull(Job& job){
+	const std::uint64_t newGeneration = generation + 1;
+	// log first (with the state at the time of the snapshot), then the
+	// snapshot, then the manifest that points to both
+	std::string newLogName = logName(prefix, newGeneration);
+	std::string tmpLogName = newLogName + ".tmp";
+	std::FILE* newLog = std::fopen(tmpLogName.c_str(), "wb");
+	if(newLog == nullptr){
+		throw std::runtime_error("Unable to open " + tmpLogName);
+	}
+	try{
+		appendRecord(newLog, job.payload);
+	}
+	catch(...){
+		std::fclose(newLog);
+		throw;
+	}
+	std::fclose(newLog);
+	if(std::rename(tmpLogName.c_str(), newLogName.c_str()) != 0){
+		throw std::runtime_error("Error writing " + newLogName);
+	}
+	writeFileAtomic(snapshotName(prefix, newGeneration), job.snapshot.data(),
+			job.snapshot.size());
+	std::string manifest = std::to_string(newGeneration) + "\n";
+	writeFileAtomic(manifestName(prefix), manifest.data(), manifest.size());
+
+	if(log != nullptr){
+		std::fclose(log);
+	}
+	log = std::fopen(newLogName.c_str(), "ab");
+	if(log == nullptr){
+		throw std::runtime_error("Unable to open " + newLogName);
+	}
+	if(generation > 0){ // previous generation is no longer needed
+		std::remove(snapshotName(prefix, generation).c_str());
+		std::remove(logName(prefix, generation).c_str());
+	}
+	generation = newGeneration;
+}
+
+void CheckpointWriter::writeDelta(Job& job){
+	bool rejected;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		rejected = fullRequired;
+	}
+	if(rejected || log == nullptr){
+		throw std::runtime_error("Checkpoint delta without a full checkpoint");
+	}
+	appendRecord(log, job.payload);
+}
+
+void CheckpointWriter::writerLoop(){
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true){
+		wake.wait(lock, [this](){return stopping || !jobs.empty();});
+		if(jobs.empty()){
+			break; // stopping and nothing left to write
+		}
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		busy = true;
+		lock.unlock();
+		std::string error;
+		try{
+			if(job.full){
+				writeFull(job);
+			}
+			else{
+				writeDelta(job);
+			}
+		}
+		catch(const std::runtime_error& e){
+			error = e.what();
+		}
+		lock.lock();
+		busy = false;
+		if(error.empty()){
+			++N_written;
+			if(job.full){
+				fullRequired = false;
+			}
+		}
+		else{
+			lastError = error;
+			fullRequired = true;
+		}
+		if(jobs.empty()){
+			idle.notify_all();
+		}
+	}
+}
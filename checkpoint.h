@@ -0,0 +1,114 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "std_lib_facilities.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// Checkpoint files of a running RRT_star (see RRT_star::setCheckpointing and
+// RRT_star::resumeFromCheckpoint)
+// A checkpoint generation g consists of
+// <prefix>.<g>.rrtsnap  full snapshot of the tree (snapshot_format.h)
+// <prefix>.<g>.rrtlog   log of records, appended as the run goes on
+// <prefix>.ckpt         manifest, the number of the latest complete generation
+// Each record holds the tree events since the previous record, in the order
+// they happened (nodes added, rewires), followed by the planner state at the
+// time of the record (iterations, random generator, sample source,
+// counters) as text. The first record of a log holds no events, only the
+// state at the time of the snapshot. Resuming loads the snapshot and
+// replays the log; a record cut short by a crash ends the log.
+//
+// Record layout: CheckpointRecordHeader, then the payload
+// uint64_t N_events
+// CheckpointEvent events[N_events]
+// uint64_t stateBytes
+// char state[stateBytes]
+
+const char CHECKPOINT_MAGIC[8] = {'R','R','T','C','K','P','T','\0'};
+
+struct CheckpointRecordHeader{
+	char magic[8];
+	std::uint64_t payloadBytes = 0;
+	std::uint64_t checksum = 0; // FNV-1a of the payload
+};
+
+struct CheckpointEvent{
+	std::uint64_t type = 'N'; // 'N' node added, 'R' rewire
+	std::uint64_t index = 0;
+	std::int64_t parent = -1;
+	double x = 0;
+	double y = 0;
+	double cost = 0;
+};
+
+std::uint64_t checkpointChecksum(const char* data, const std::size_t size);
+
+// payload of a record, see the layout above
+void encodeCheckpointRecord(const std::vector<CheckpointEvent>& events,
+		const std::string& state, std::vector<char>& payload);
+void decodeCheckpointRecord(const char* payload, const std::size_t size,
+		std::vector<CheckpointEvent>& events, std::string& state);
+
+// Background writer of the checkpoint files
+// submit* hands a checkpoint over to the writer thread and returns
+// immediately; the planner only submits when isIdle() (see
+// RRT_star::checkpoint), so at most one checkpoint is queued.
+// Files are written to a temporary name and renamed, the manifest last, so
+// that the latest generation on disk is always complete.
+class CheckpointWriter{
+	struct Job{
+		bool full = false;
+		std::vector<char> snapshot; // full checkpoints only
+		std::vector<char> payload; // record
+	};
+	std::string prefix;
+	std::uint64_t generation = 0; // writer thread only
+	std::FILE* log = nullptr; // writer thread only
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	std::deque<Job> jobs;
+	bool busy = false;
+	bool stopping = false;
+	bool fullRequired = true; // no full checkpoint yet, or a write failed
+	std::uint64_t N_written = 0;
+	std::string lastError;
+	std::thread writer;
+
+	void writerLoop();
+	void writeFull(Job& job);
+	void writeDelta(Job& job);
+	void appendRecord(std::FILE* os, const std::vector<char>& payload);
+	public:
+		// continues the generation numbering of an existing manifest
+		CheckpointWriter(const std::string& prefix_in);
+		~CheckpointWriter(); // writes the queued checkpoints and joins the writer
+		CheckpointWriter(const CheckpointWriter&) = delete;
+		CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+		void submitFull(std::vector<char> snapshot, std::vector<char> payload);
+		void submitDelta(std::vector<char> payload);
+		bool isIdle(); // nothing queued or being written
+		// the next checkpoint has to be full: none was written yet, or a
+		// write failed (deltas are rejected until then, so the log never
+		// has gaps)
+		bool isFullRequired();
+		void waitIdle(); // blocks until the submitted checkpoints are on disk
+		std::uint64_t getWritten(); // checkpoints written so far
+		std::string getLastError(); // empty if every write succeeded
+
+		static std::string manifestName(const std::string& prefix);
+		static std::string snapshotName(const std::string& prefix,
+				const std::uint64_t generation);
+		static std::string logName(const std::string& prefix,
+				const std::uint64_t generation);
+		// generation in the manifest, throws std::runtime_error if there is none
+		static std::uint64_t latestGeneration(const std::string& prefix);
+		// calls onRecord(payload, size) for each complete record of a log,
+		// in order, and stops at the first incomplete or corrupt one
+		static void readLog(const std::string& filename,
+				const std::function<void(const char*, std::size_t)>& onRecord);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef COST_METRICS_CPP
+#define COST_METRICS_CPP
+#include "cost_metrics.h"
+
+template<typename T>
+EdgeCostFunction<T> euclideanLengthCost(){
+	return [](const std::shared_ptr<T>& from, const std::shared_ptr<T>& to){
+		return std::hypot(to->getX() - from->getX(), to->getY() - from->getY());
+	};
+}
+
+template<typename T>
+EdgeCostFunction<T> squaredLengthCost(){
+	return [](const std::shared_ptr<T>& from, const std::shared_ptr<T>& to){
+		double dx = to->getX() - from->getX();
+		double dy = to->getY() - from->getY();
+		return dx*dx + dy*dy;
+	};
+}
+
+template<typename T>
+EdgeCostFunction<T> clearanceLengthCost(std::shared_ptr<const DistanceField> field,
+		const double safeDistance, const double weight){
+	assert(field != nullptr && safeDistance > 0 && weight >= 0);
+	auto penalty = [field, safeDistance](const std::shared_ptr<T>& item){
+		double clearance = field->getClearance(item->getX(), item->getY());
+		return 1.0 - std::min(std::max(clearance, 0.0), safeDistance) / safeDistance;
+	};
+	return [penalty, weight](const std::shared_ptr<T>& from, const std::shared_ptr<T>& to){
+		double length = std::hypot(to->getX() - from->getX(), to->getY() - from->getY());
+		return length * (1.0 + 0.5 * weight * (penalty(from) + penalty(to)));
+	};
+}
+
+template<typename T>
+CostToGoFunction<T> regionDistanceCostToGo(const Obstacle& goalRegion){
+	// region spans [x, x+dx] by [y-dy, y] (Obstacle convention)
+	double left = goalRegion.getX();
+	double right = goalRegion.getX() + goalRegion.getdx();
+	double top = goalRegion.getY();
+	double bottom = goalRegion.getY() - goalRegion.getdy();
+	return [left, right, top, bottom](const std::shared_ptr<T>& item){
+		double dx = std::max({left - item->getX(), 0.0, item->getX() - right});
+		double dy = std::max({bottom - item->getY(), 0.0, item->getY() - top});
+		return std::hypot(dx, dy);
+	};
+}
+
+#endif
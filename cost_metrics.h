@@ -0,0 +1,48 @@
+#ifndef COST_METRICS_H
+#define COST_METRICS_H
+#include "std_lib_facilities.h"
+#include "environment_classes.h"
+#include "distance_field.h"
+
+// Edge cost metrics and cost-to-go heuristics for RRT_star
+// (RRT_star::setEdgeCost and RRT_star::setCostToGo)
+// An edge cost is the cost of the edge from a parent item to a child item.
+// It has to be positive between distinct items, so that costs grow along
+// every path of the tree. A cost-to-go has to be admissible for the edge
+// cost it is used with, i.e. never above the cost of the cheapest path from
+// the item into the goal region.
+//
+// Without a metric RRT_star uses T::calculateCost, the squared edge length
+// (the tree then minimises the sum of squared edge lengths, which favours
+// many short edges over the shortest path). squaredLengthCost has the same
+// behaviour and has no useful cost-to-go other than 0.
+//
+// Requirements of the template T type/class: getX()/getY()
+template<typename T>
+using EdgeCostFunction = std::function<double(const std::shared_ptr<T>&,
+		const std::shared_ptr<T>&)>;
+template<typename T>
+using CostToGoFunction = std::function<double(const std::shared_ptr<T>&)>;
+
+// path length
+template<typename T>
+EdgeCostFunction<T> euclideanLengthCost();
+
+// sum of squared edge lengths, an energy-like cost that penalises long jumps
+template<typename T>
+EdgeCostFunction<T> squaredLengthCost();
+
+// path length plus a clearance penalty: each unit of length costs
+// 1 + weight * p, where p falls linearly from 1 at an obstacle to 0 at
+// safeDistance (clearance from field, averaged over the two ends of the
+// edge). Never below the length, so regionDistanceCostToGo stays admissible.
+template<typename T>
+EdgeCostFunction<T> clearanceLengthCost(std::shared_ptr<const DistanceField> field,
+		const double safeDistance, const double weight);
+
+// straight line distance to the goal region, admissible for
+// euclideanLengthCost
+template<typename T>
+CostToGoFunction<T> regionDistanceCostToGo(const Obstacle& goalRegion);
+
+#endif
@@ -0,0 +1,205 @@
+#include "distance_field.h"
+#include <cmath>
+#include <future>
+#include <limits>
+
+// squared distance standing for "no seed in range"
+static const double FIELD_FAR = std::numeric_limits<double>::max();
+
+// Runs fn(begin, end) on N_tasks slices of [0, N_items)
+// A single slice runs on the calling thread: starting a thread makes every
+// later shared_ptr copy in the process atomic, which the planner would pay
+// for on every iteration.
+template<typename Function>
+static void parallelRanges(const int N_items, const int N_tasks, Function fn){
+	if(N_tasks <= 1){
+		fn(0, N_items);
+		return;
+	}
+	std::vector<std::future<void>> futures;
+	for(int k = 0; k < N_tasks; ++k){
+		int begin = int(std::int64_t(N_items) * k / N_tasks);
+		int end = int(std::int64_t(N_items) * (k + 1) / N_tasks);
+		futures.emplace_back(std::async(std::launch::async, fn, begin, end));
+	}
+	for(auto& f : futures){
+		f.get();
+	}
+}
+
+// One dimensional squared distance transform (Felzenszwalb and
+// Huttenlocher): d[q] = min over p of (q-p)^2 + f[p]. Entries equal to
+// FIELD_FAR are no seeds and are left out of the lower envelope. v and z
+// are scratch space of at least n and n+1 entries.
+static void distanceTransform1D(const double* f, double* d, const int n,
+		int* v, double* z){
+	int k = -1;
+	for(int q = 0; q < n; ++q){
+		if(f[q] == FIELD_FAR){
+			continue;
+		}
+		double s = -std::numeric_limits<double>::infinity();
+		while(k >= 0){
+			s = ((f[q] + double(q)*q) - (f[v[k]] + double(v[k])*v[k]))
+				/ (2.0 * (q - v[k]));
+			if(s > z[k]){
+				break;
+			}
+			--k;
+		}
+		++k;
+		v[k] = q;
+		z[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+		z[k+1] = std::numeric_limits<double>::infinity();
+	}
+	if(k < 0){
+		std::fill(d, d + n, FIELD_FAR);
+		return;
+	}
+	k = 0;
+	for(int q = 0; q < n; ++q){
+		while(z[k+1] < q){
+			++k;
+		}
+		d[q] = double(q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+// Squared distance (in cells) from every cell to the nearest cell with
+// seed[cell] == seedValue, columns first, then rows
+static std::vector<double> distanceTransform2D(const std::vector<char>& seed,
+		const char seedValue, const int N_x, const int N_y, const int N_tasks){
+	std::vector<double> columnPass(seed.size());
+	parallelRanges(N_x, N_tasks, [&](int begin, int end){
+		std::vector<double> f(N_y), d(N_y), z(N_y + 1);
+		std::vector<int> v(N_y);
+		for(int x = begin; x < end; ++x){
+			for(int y = 0; y < N_y; ++y){
+				f[y] = seed[std::size_t(y) * N_x + x] == seedValue ? 0 : FIELD_FAR;
+			}
+			distanceTransform1D(f.data(), d.data(), N_y, v.data(), z.data());
+			for(int y = 0; y < N_y; ++y){
+				columnPass[std::size_t(y) * N_x + x] = d[y];
+			}
+		}
+	});
+	std::vector<double> result(seed.size());
+	parallelRanges(N_y, N_tasks, [&](int begin, int end){
+		std::vector<double> z(N_x + 1);
+		std::vector<int> v(N_x);
+		for(int y = begin; y < end; ++y){
+			std::size_t row = std::size_t(y) * N_x;
+			distanceTransform1D(columnPass.data() + row, result.data() + row,
+					N_x, v.data(), z.data());
+		}
+	});
+	return result;
+}
+
+// float not above value
+static float roundDown(const double value){
+	float f = float(value);
+	if(double(f) > value){
+		f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+	}
+	return f;
+}
+
+DistanceField::DistanceField(const Environment& env, double cellSize_in,
+		int N_threads){
+	double longSide = std::max(env.getDeltaX(), env.getDeltaY());
+	assert(longSide > 0);
+	if(cellSize_in <= 0){
+		cellSize_in = longSide / 1024;
+	}
+	cellSize = std::max(cellSize_in, longSide / 8192); // bounds the number of cells
+	N_x = std::max(1, int(std::ceil(env.getDeltaX() / cellSize)));
+	N_y = std::max(1, int(std::ceil(env.getDeltaY() / cellSize)));
+	if(N_threads <= 0){
+		N_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+	}
+	int N_tasks = std::min(N_threads, std::max(1, std::min(N_x, N_y) / 64));
+
+	// mark the cells touching an obstacle, each task marks a band of rows.
+	// Cell indices are clamped, so obstacles (partly) outside the raster mark
+	// the border cells closest to them, which keeps the bounds conservative
+	// for points inside the raster.
+	std::size_t N_obstacles = env.getNumObstacles();
+	const double* obsX = env.getObstacleX();
+	const double* obsY = env.getObstacleY();
+	const double* obsDX = env.getObstacleDX();
+	const double* obsDY = env.getObstacleDY();
+	auto cellIndex = [this](const double v, const int N){
+		double c = std::floor(v / cellSize);
+		return int(std::min(std::max(c, 0.0), double(N - 1)));
+	};
+	std::vector<char> occupied(std::size_t(N_x) * N_y, 0);
+	parallelRanges(N_y, N_tasks, [&](int begin, int end){
+		for(std::size_t i = 0; i < N_obstacles; ++i){
+			// obstacle i spans [x, x+dx] by [y-dy, y]
+			int r0 = std::max(cellIndex(obsY[i] - obsDY[i], N_y), begin);
+			int r1 = std::min(cellIndex(obsY[i], N_y), end - 1);
+			if(r0 > r1){
+				continue;
+			}
+			int c0 = cellIndex(obsX[i], N_x);
+			int c1 = cellIndex(obsX[i] + obsDX[i], N_x);
+			for(int r = r0; r <= r1; ++r){
+				std::fill(occupied.begin() + std::size_t(r) * N_x + c0,
+						occupied.begin() + std::size_t(r) * N_x + c1 + 1, 1);
+			}
+		}
+	});
+
+	std::vector<double> toObstacle = distanceTransform2D(occupied, 1, N_x, N_y, N_tasks);
+	std::vector<double> toFree = distanceTransform2D(occupied, 0, N_x, N_y, N_tasks);
+
+	// any point of a cell is within half a diagonal of its centre; the
+	// margin absorbs the rounding of the cell lookup
+	const double halfDiagonal = std::sqrt(0.5);
+	const double margin = 1e-9 * cellSize;
+	clearance.resize(occupied.size());
+	parallelRanges(N_y, N_tasks, [&](int begin, int end){
+		for(std::size_t c = std::size_t(begin) * N_x; c < std::size_t(end) * N_x; ++c){
+			double value;
+			if(occupied[c] == 0){
+				value = toObstacle[c] == FIELD_FAR ? std::numeric_limits<double>::infinity()
+					: std::max(0.0, (std::sqrt(toObstacle[c]) - 2 * halfDiagonal)
+							* cellSize - margin);
+			}
+			else{
+				value = toFree[c] == FIELD_FAR ? -std::numeric_limits<double>::infinity()
+					: -(std::sqrt(toFree[c]) + halfDiagonal) * cellSize - margin;
+			}
+			clearance[c] = roundDown(value);
+		}
+	});
+}
+
+double DistanceField::getClearance(const double px, const double py) const{
+	double cx = px / cellSize;
+	double cy = py / cellSize;
+	if(!(cx >= 0 && cx <= N_x && cy >= 0 && cy <= N_y)){
+		return -std::numeric_limits<double>::infinity();
+	}
+	int x = std::min(int(cx), N_x - 1);
+	int y = std::min(int(cy), N_y - 1);
+	return clearance[std::size_t(y) * N_x + x];
+}
+
+bool DistanceField::segmentClear(const double x1, const double y1,
+		const double x2, const double y2) const{
+	// every point of the segment is within half its length of an end
+	double halfLength = 0.5 * std::hypot(x2 - x1, y2 - y1);
+	return getClearance(x1, y1) > halfLength && getClearance(x2, y2) > halfLength;
+}
+
+double DistanceField::getCellSize() const{
+	return cellSize;
+}
+int DistanceField::getNumCellsX() const{
+	return N_x;
+}
+int DistanceField::getNumCellsY() const{
+	return N_y;
+}
@@ -0,0 +1,50 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+#include "std_lib_facilities.h"
+#include "environment_classes.h"
+
+// Precomputed clearance of an Environment (see RRT_star::setDistanceField)
+// The environment is rasterized into square cells, and each cell stores a
+// lower bound on the signed distance from any point in it to the nearest
+// obstacle: positive outside the obstacles, negative inside. The bound is
+// conservative (never above the exact signed distance), so it can prove an
+// edge free but never that an edge collides:
+// if both ends of a segment have clearance above half its length, every
+// point of the segment lies within that clearance of one of its ends, hence
+// the segment is obstacle free (segmentClear). Other segments need the
+// exact test (Environment::segmentFree).
+//
+// The bounds come from two exact Euclidean distance transforms of the cell
+// raster (Felzenszwalb and Huttenlocher), one to the cells touching an
+// obstacle and one to the free cells, each done as a pass over the columns
+// and a pass over the rows split across threads. A cell-centre distance of
+// D cells gives a clearance of at least (D - sqrt(2)) cells for the free
+// cells, and a depth of at most D + sqrt(2)/2 cells for the others, so the
+// bounds are within about one and a half cells of the exact distance.
+//
+// The field is a copy: obstacles added to the environment afterwards are not
+// in it, build it once the environment is complete.
+class DistanceField{
+	double cellSize = 1;
+	int N_x = 0; // cells in the x direction
+	int N_y = 0;
+	// lower bound on the signed distance per cell, row by row (rows along y)
+	std::vector<float> clearance;
+	public:
+		// cellSize <= 0 picks 1/1024 of the longer environment side,
+		// N_threads <= 0 uses all hardware threads
+		DistanceField(const Environment& env, double cellSize_in = 0,
+				int N_threads = 0);
+		// lower bound on the signed distance from (px,py) to the nearest
+		// obstacle, -infinity outside the environment (no bound there)
+		double getClearance(const double px, const double py) const;
+		// true if the segment from (x1,y1) to (x2,y2) is certainly obstacle
+		// free; false means it has to be checked exactly
+		bool segmentClear(const double x1, const double y1, const double x2,
+				const double y2) const;
+		double getCellSize() const;
+		int getNumCellsX() const;
+		int getNumCellsY() const;
+};
+
+#endif
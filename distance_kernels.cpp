@@ -0,0 +1,179 @@
+#include "distance_kernels.h"
+#include <limits>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Scalar versions, used for the whole range when no vector instruction set
+// is available and for the leftover tail of the vectorised loops
+static std::size_t nearestIndexScalar(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double& bestDistSq){
+	std::size_t bestIndex = end;
+	for(std::size_t i = begin; i < end; ++i){
+		double dx = xs[i] - px;
+		double dy = ys[i] - py;
+		double distance = dx*dx + dy*dy;
+		if(bestIndex == end || distance < bestDistSq){
+			bestIndex = i;
+			bestDistSq = distance;
+		}
+	}
+	return bestIndex;
+}
+
+static void nearIndicesScalar(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double radiusSq,
+		std::vector<std::size_t>& out, std::vector<double>* outDistSq){
+	for(std::size_t i = begin; i < end; ++i){
+		double dx = xs[i] - px;
+		double dy = ys[i] - py;
+		double distance = dx*dx + dy*dy;
+		if(distance <= radiusSq){
+			out.push_back(i);
+			if(outDistSq != nullptr){
+				outDistSq->push_back(distance);
+			}
+		}
+	}
+}
+
+#if defined(__AVX512F__)
+static const std::size_t LANES = 8;
+#elif defined(__AVX2__)
+static const std::size_t LANES = 4;
+#endif
+
+std::size_t nearestIndexBatch(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double& bestDistSq){
+#if defined(__AVX512F__) || defined(__AVX2__)
+	std::size_t n_vector = (end - begin) / LANES * LANES;
+	if(n_vector == 0){
+		return nearestIndexScalar(xs, ys, begin, end, px, py, bestDistSq);
+	}
+	// Each lane keeps its own running minimum and the index where it was
+	// found (indices are held as doubles, exact up to 2^53), lanes are
+	// reduced once at the end
+	double laneDist[LANES];
+	double laneIndex[LANES];
+#if defined(__AVX512F__)
+	const __m512d vpx = _mm512_set1_pd(px);
+	const __m512d vpy = _mm512_set1_pd(py);
+	const __m512d step = _mm512_set1_pd(double(LANES));
+	__m512d index = _mm512_setr_pd(0,1,2,3,4,5,6,7);
+	index = _mm512_add_pd(index, _mm512_set1_pd(double(begin)));
+	__m512d best = _mm512_set1_pd(std::numeric_limits<double>::infinity());
+	__m512d bestIndex = index;
+	for(std::size_t i = begin; i < begin + n_vector; i += LANES){
+		__m512d dx = _mm512_sub_pd(_mm512_loadu_pd(xs + i), vpx);
+		__m512d dy = _mm512_sub_pd(_mm512_loadu_pd(ys + i), vpy);
+		__m512d d = _mm512_add_pd(_mm512_mul_pd(dx, dx),
+				_mm512_mul_pd(dy, dy));
+		__mmask8 closer = _mm512_cmp_pd_mask(d, best, _CMP_LT_OQ);
+		best = _mm512_mask_blend_pd(closer, best, d);
+		bestIndex = _mm512_mask_blend_pd(closer, bestIndex, index);
+		index = _mm512_add_pd(index, step);
+	}
+	_mm512_storeu_pd(laneDist, best);
+	_mm512_storeu_pd(laneIndex, bestIndex);
+#else
+	const __m256d vpx = _mm256_set1_pd(px);
+	const __m256d vpy = _mm256_set1_pd(py);
+	const __m256d step = _mm256_set1_pd(double(LANES));
+	__m256d index = _mm256_setr_pd(0,1,2,3);
+	index = _mm256_add_pd(index, _mm256_set1_pd(double(begin)));
+	__m256d best = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+	__m256d bestIndex = index;
+	for(std::size_t i = begin; i < begin + n_vector; i += LANES){
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), vpx);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), vpy);
+		__m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx),
+				_mm256_mul_pd(dy, dy));
+		__m256d closer = _mm256_cmp_pd(d, best, _CMP_LT_OQ);
+		best = _mm256_blendv_pd(best, d, closer);
+		bestIndex = _mm256_blendv_pd(bestIndex, index, closer);
+		index = _mm256_add_pd(index, step);
+	}
+	_mm256_storeu_pd(laneDist, best);
+	_mm256_storeu_pd(laneIndex, bestIndex);
+#endif
+	std::size_t bestI = std::size_t(laneIndex[0]);
+	double bestD = laneDist[0];
+	for(std::size_t lane = 1; lane < LANES; ++lane){
+		std::size_t laneI = std::size_t(laneIndex[lane]);
+		if(laneDist[lane] < bestD ||
+				(laneDist[lane] == bestD && laneI < bestI)){
+			bestD = laneDist[lane];
+			bestI = laneI;
+		}
+	}
+	// tail that did not fill a whole vector, indices are all higher so
+	// only a strictly closer point replaces the vector result
+	double tailDist = bestD;
+	std::size_t tailI = nearestIndexScalar(xs, ys, begin + n_vector, end,
+			px, py, tailDist);
+	if(tailI != end && tailDist < bestD){
+		bestD = tailDist;
+		bestI = tailI;
+	}
+	bestDistSq = bestD;
+	return bestI;
+#else
+	return nearestIndexScalar(xs, ys, begin, end, px, py, bestDistSq);
+#endif
+}
+
+void nearIndicesBatch(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double radiusSq,
+		std::vector<std::size_t>& out, std::vector<double>* outDistSq){
+#if defined(__AVX512F__) || defined(__AVX2__)
+	std::size_t n_vector = (end - begin) / LANES * LANES;
+	std::size_t i = begin;
+	double laneDist[LANES];
+#if defined(__AVX512F__)
+	const __m512d vpx = _mm512_set1_pd(px);
+	const __m512d vpy = _mm512_set1_pd(py);
+	const __m512d vr = _mm512_set1_pd(radiusSq);
+	for(; i < begin + n_vector; i += LANES){
+		__m512d dx = _mm512_sub_pd(_mm512_loadu_pd(xs + i), vpx);
+		__m512d dy = _mm512_sub_pd(_mm512_loadu_pd(ys + i), vpy);
+		__m512d d = _mm512_add_pd(_mm512_mul_pd(dx, dx),
+				_mm512_mul_pd(dy, dy));
+		unsigned inside = _mm512_cmp_pd_mask(d, vr, _CMP_LE_OQ);
+		if(inside && outDistSq != nullptr){
+			_mm512_storeu_pd(laneDist, d);
+		}
+#else
+	const __m256d vpx = _mm256_set1_pd(px);
+	const __m256d vpy = _mm256_set1_pd(py);
+	const __m256d vr = _mm256_set1_pd(radiusSq);
+	for(; i < begin + n_vector; i += LANES){
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), vpx);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), vpy);
+		__m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx),
+				_mm256_mul_pd(dy, dy));
+		unsigned inside = _mm256_movemask_pd(
+				_mm256_cmp_pd(d, vr, _CMP_LE_OQ));
+		if(inside && outDistSq != nullptr){
+			_mm256_storeu_pd(laneDist, d);
+		}
+#endif
+		// near sets are small compared to the tree, most blocks have no
+		// bits set and skip straight to the next load
+		while(inside){
+			int lane = __builtin_ctz(inside);
+			out.push_back(i + lane);
+			if(outDistSq != nullptr){
+				outDistSq->push_back(laneDist[lane]);
+			}
+			inside &= inside - 1;
+		}
+	}
+	nearIndicesScalar(xs, ys, i, end, px, py, radiusSq, out, outDistSq);
+#else
+	nearIndicesScalar(xs, ys, begin, end, px, py, radiusSq, out, outDistSq);
+#endif
+}
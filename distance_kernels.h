@@ -0,0 +1,29 @@
+#ifndef DISTANCE_KERNELS_H
+#define DISTANCE_KERNELS_H
+#include "std_lib_facilities.h"
+#include <cstddef>
+
+// Batch distance kernels used by the nearest and near node searches of RRT_star.
+// Coordinates are stored as contiguous arrays (one for x, one for y), so each
+// kernel streams through memory and compares several nodes per instruction:
+// 8 doubles with AVX-512, 4 doubles with AVX2, and a plain scalar loop
+// otherwise (the instruction set is chosen at compile time, e.g. -march=native).
+// All distances are squared, same as Point::calculateCost.
+
+// Returns the index in [begin,end) of the coordinate closest to (px,py) and
+// writes its squared distance to bestDistSq. On ties the lowest index wins.
+// Returns end (and leaves bestDistSq untouched) if the range is empty.
+std::size_t nearestIndexBatch(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double& bestDistSq);
+
+// Appends to out the index of every coordinate in [begin,end) that lies within
+// sqrt(radiusSq) of (px,py), in increasing index order. If outDistSq is given,
+// the squared distance of each of them is appended to it in the same order.
+void nearIndicesBatch(const double* xs, const double* ys,
+		std::size_t begin, std::size_t end,
+		double px, double py, double radiusSq,
+		std::vector<std::size_t>& out,
+		std::vector<double>* outDistSq = nullptr);
+
+#endif
@@ -1,5 +1,8 @@
 #include "environment_classes.h"
+#include "mapped_file.h"
+#include <charconv>
 #include <cmath>
+#include <cstring>
 #include <random>
 
 Environment::Environment(double setdeltaX, double setdeltaY){
@@ -16,27 +19,315 @@ double Environment::getDeltaY() const{
 
 // functions
 void Environment::addObstacle(std::shared_ptr<Obstacle> obs){// Add an obstacle to the environement
-	obstacleList.push_back(obs);
+	obstacleX.push_back(obs->getX());
+	obstacleY.push_back(obs->getY());
+	obstacleDX.push_back(obs->getdx());
+	obstacleDY.push_back(obs->getdy());
+	gridValid = false;
+}
+
+void Environment::addObstacles(const double* values, const std::size_t N_obstacles){
+	std::size_t N_total = obstacleX.size() + N_obstacles;
+	obstacleX.reserve(N_total);
+	obstacleY.reserve(N_total);
+	obstacleDX.reserve(N_total);
+	obstacleDY.reserve(N_total);
+	for(std::size_t i = 0; i < N_obstacles; ++i){
+		obstacleX.push_back(values[4*i]);
+		obstacleY.push_back(values[4*i+1]);
+		obstacleDX.push_back(values[4*i+2]);
+		obstacleDY.push_back(values[4*i+3]);
+	}
+	gridValid = false;
 }
 
 std::vector<std::shared_ptr<Obstacle>> Environment::getObstacleList() const{// return a vector of obstacles that exist in the environment
+	std::vector<std::shared_ptr<Obstacle>> obstacleList;
+	obstacleList.reserve(obstacleX.size());
+	for(std::size_t i = 0; i < obstacleX.size(); ++i){
+		obstacleList.push_back(std::make_shared<Obstacle>(obstacleX[i],
+			obstacleY[i], obstacleDX[i], obstacleDY[i]));
+	}
 	return obstacleList;
 }
+
+std::size_t Environment::getNumObstacles() const{
+	return obstacleX.size();
+}
+const double* Environment::getObstacleX() const{
+	return obstacleX.data();
+}
+const double* Environment::getObstacleY() const{
+	return obstacleY.data();
+}
+const double* Environment::getObstacleDX() const{
+	return obstacleDX.data();
+}
+const double* Environment::getObstacleDY() const{
+	return obstacleDY.data();
+}
+
 bool Environment::obstacleFree(std::shared_ptr<Point> p) const{// check if a point does not fall in an obstacle in the environment
-	bool indicator = true;
-	if(obstacleList.empty()){//if no obstacles, point is obstacle free automatically
-		return indicator;
-	}	
-	else{ 
-		for(const auto it: obstacleList){//iterate through obstacles and check if point is in each obstacle
-			indicator  = it->inObstacle(p);
-			if(indicator){//if point is in an obstacle, return false immediately, no need to iterate further
+	return pointFree(p->getX(), p->getY());
+}
+
+// same test as Obstacle::inObstacle, negated
+bool Environment::pointFreeOf(const std::uint32_t i, const double px, const double py) const{
+	bool xCheck = (px >= obstacleX[i]) && (px <= obstacleX[i]+obstacleDX[i]);
+	bool yCheck = (py <= obstacleY[i]) && (py >= obstacleY[i]-obstacleDY[i]);
+	return !(xCheck && yCheck);
+}
+
+bool Environment::pointFree(const double px, const double py) const{
+	if(gridValid){
+		int c = gridRow(py) * gridNX + gridColumn(px);
+		for(std::uint32_t k = gridCellStart[c]; k < gridCellStart[c+1]; ++k){
+			if(!pointFreeOf(gridObstacles[k], px, py)){
 				return false;
 			}
 		}
-	//if for loop completes successfully, no obstacles are hit
 		return true;
 	}
+	for(std::uint32_t i = 0; i < obstacleX.size(); ++i){//iterate through obstacles and check if point is in each obstacle
+		if(!pointFreeOf(i, px, py)){//if point is in an obstacle, return false immediately, no need to iterate further
+			return false;
+		}
+	}
+	return true;
+}
+
+// Intersection test between the segments (x1,y1)-(x2,y2) and (x3,y3)-(x4,y4),
+// shared by Line::intersectCheck and the flat obstacle storage
+static bool segmentsIntersect(const double x1, const double y1,
+		const double x2, const double y2, const double x3, const double y3,
+		const double x4, const double y4){
+	double check1 = ((x4-x3)*(y1-y3) - (y4-y3)*(x1-x3)) /
+		((y4-y3)*(x2-x1) - (x4-x3)*(y2-y1));
+	double check2 = ((x2-x1)*(y1-y3) - (y2-y1)*(x1-x3)) /
+		((y4-y3)*(x2-x1) - (x4-x3)*(y2-y1));
+	return check1 >= 0 && check1 <= 1 && check2 >= 0 && check2 <= 1;
+}
+
+// Same edges, in the same order, as Obstacle::lineIntersects
+bool Environment::segmentHits(const std::uint32_t i, const double x1, const double y1,
+		const double x2, const double y2) const{
+	double left = obstacleX[i];
+	double right = obstacleX[i] + obstacleDX[i];
+	double top = obstacleY[i];
+	double bottom = obstacleY[i] - obstacleDY[i];
+	return segmentsIntersect(x1, y1, x2, y2, left, top, right, top) ||
+		segmentsIntersect(x1, y1, x2, y2, left, top, left, bottom) ||
+		segmentsIntersect(x1, y1, x2, y2, right, top, right, bottom) ||
+		segmentsIntersect(x1, y1, x2, y2, left, bottom, right, bottom);
+}
+
+bool Environment::segmentFree(const double x1, const double y1, const double x2,
+		const double y2, std::uint64_t* p_obstacleTests) const{
+	if(!pointFree(x1, y1) || !pointFree(x2, y2)){
+		return false;
+	}
+	std::uint64_t N_tests = 0;
+	bool free = true;
+	int c0 = 0, c1 = 0, r0 = 0, r1 = 0;
+	if(gridValid){
+		c0 = gridColumn(std::min(x1, x2));
+		c1 = gridColumn(std::max(x1, x2));
+		r0 = gridRow(std::min(y1, y2));
+		r1 = gridRow(std::max(y1, y2));
+	}
+	// obstacles spanning several cells are tested once per cell, so long
+	// segments covering many cells test every obstacle once instead
+	if(gridValid && std::size_t(c1-c0+1) * std::size_t(r1-r0+1) < obstacleX.size()){
+		for(int r = r0; r <= r1 && free; ++r){
+			for(int c = r * gridNX + c0; c <= r * gridNX + c1 && free; ++c){
+				for(std::uint32_t k = gridCellStart[c]; k < gridCellStart[c+1]; ++k){
+					++N_tests;
+					if(segmentHits(gridObstacles[k], x1, y1, x2, y2)){
+						free = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+	else{
+		for(std::uint32_t i = 0; i < obstacleX.size(); ++i){
+			++N_tests;
+			if(segmentHits(i, x1, y1, x2, y2)){
+				free = false;
+				break;
+			}
+		}
+	}
+	if(p_obstacleTests != nullptr){
+		*p_obstacleTests += N_tests;
+	}
+	return free;
+}
+
+int Environment::gridColumn(const double px) const{
+	int c = int(std::floor(px / gridCellSize));
+	return std::min(std::max(c, 0), gridNX - 1);
+}
+
+int Environment::gridRow(const double py) const{
+	int r = int(std::floor(py / gridCellSize));
+	return std::min(std::max(r, 0), gridNY - 1);
+}
+
+void Environment::buildObstacleGrid(double cellSize){
+	std::size_t N = obstacleX.size();
+	if(cellSize <= 0){
+		// about one obstacle per cell on average
+		cellSize = std::sqrt(deltaX * deltaY / double(std::max<std::size_t>(N, 1)));
+	}
+	cellSize = std::max(cellSize, getMaxDistance() / 4096); // bounds the number of cells
+	gridCellSize = cellSize;
+	gridNX = std::max(1, int(std::ceil(deltaX / cellSize)));
+	gridNY = std::max(1, int(std::ceil(deltaY / cellSize)));
+
+	// count the obstacles in each cell, prefix sum, then fill (CSR layout)
+	std::vector<std::uint32_t> counts(std::size_t(gridNX) * gridNY + 1, 0);
+	for(std::size_t i = 0; i < N; ++i){
+		int c0 = gridColumn(obstacleX[i]), c1 = gridColumn(obstacleX[i] + obstacleDX[i]);
+		int r0 = gridRow(obstacleY[i] - obstacleDY[i]), r1 = gridRow(obstacleY[i]);
+		for(int r = r0; r <= r1; ++r){
+			for(int c = c0; c <= c1; ++c){
+				++counts[r * gridNX + c + 1];
+			}
+		}
+	}
+	for(std::size_t c = 1; c < counts.size(); ++c){
+		counts[c] += counts[c-1];
+	}
+	gridCellStart = counts;
+	gridObstacles.assign(counts.back(), 0);
+	for(std::size_t i = 0; i < N; ++i){
+		int c0 = gridColumn(obstacleX[i]), c1 = gridColumn(obstacleX[i] + obstacleDX[i]);
+		int r0 = gridRow(obstacleY[i] - obstacleDY[i]), r1 = gridRow(obstacleY[i]);
+		for(int r = r0; r <= r1; ++r){
+			for(int c = c0; c <= c1; ++c){
+				gridObstacles[counts[r * gridNX + c]++] = std::uint32_t(i);
+			}
+		}
+	}
+	gridValid = true;
+}
+
+bool Environment::hasObstacleGrid() const{
+	return gridValid;
+}
+
+// Binary obstacle map: header followed by x,y,dx,dy (double) per obstacle
+struct ObstacleFileHeader{
+	char magic[8] = {'R','R','T','O','B','S','T','\0'};
+	std::uint32_t version = 1;
+	std::uint32_t byteOrder = 0x01020304;
+	std::uint64_t N_obstacles = 0;
+};
+
+void Environment::loadObstaclesBinary(const std::string& filename){
+	MappedFile file(filename);
+	ObstacleFileHeader header;
+	const ObstacleFileHeader expected;
+	if(file.size() < sizeof(header)){
+		throw std::runtime_error(filename + " is too small for an obstacle map");
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+	if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+			header.version != expected.version ||
+			header.byteOrder != expected.byteOrder){
+		throw std::runtime_error(filename + " is not a compatible obstacle map");
+	}
+	if(file.size() != sizeof(header) + 4 * sizeof(double) * header.N_obstacles){
+		throw std::runtime_error(filename + " size does not match its header");
+	}
+	addObstacles(reinterpret_cast<const double*>(file.data() + sizeof(header)),
+			header.N_obstacles);
+	buildObstacleGrid();
+}
+
+void Environment::writeObstaclesBinary(const std::string& filename) const{
+	std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+	if(!os.is_open()){
+		throw std::runtime_error("Unable to open " + filename);
+	}
+	ObstacleFileHeader header;
+	header.N_obstacles = obstacleX.size();
+	std::vector<double> values;
+	values.reserve(4 * obstacleX.size());
+	for(std::size_t i = 0; i < obstacleX.size(); ++i){
+		values.insert(values.end(), {obstacleX[i], obstacleY[i],
+			obstacleDX[i], obstacleDY[i]});
+	}
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	os.write(reinterpret_cast<const char*>(values.data()),
+			sizeof(double) * values.size());
+	if(!os.good()){
+		throw std::runtime_error("Error writing " + filename);
+	}
+}
+
+// Parses the obstacle lines in [begin,end) (x,y,dx,dy per line) into values
+static std::vector<double> parseObstacleLines(const char* begin, const char* end){
+	std::vector<double> values;
+	values.reserve((end - begin) / 16);
+	const char* p = begin;
+	while(p < end){
+		// skip blank lines and line endings
+		if(*p == '\n' || *p == '\r' || *p == ' ' || *p == '\t'){
+			++p;
+			continue;
+		}
+		for(int field = 0; field < 4; ++field){
+			while(p < end && (*p == ' ' || *p == '\t')){++p;}
+			double value = 0;
+			auto result = std::from_chars(p, end, value);
+			if(result.ec != std::errc()){
+				throw std::runtime_error("Malformed obstacle line near byte "
+					+ std::to_string(p - begin));
+			}
+			p = result.ptr;
+			values.push_back(value);
+			while(p < end && (*p == ' ' || *p == '\t')){++p;}
+			if(field < 3){
+				if(p == end || *p != ','){
+					throw std::runtime_error("Obstacle line with fewer than 4 values");
+				}
+				++p;
+			}
+		}
+		if(p < end && *p != '\n' && *p != '\r'){
+			throw std::runtime_error("Obstacle line with more than 4 values");
+		}
+	}
+	return values;
+}
+
+void Environment::loadObstaclesCSV(const std::string& filename){
+	MappedFile file(filename);
+	const char* data = file.data();
+	const char* dataEnd = data + file.size();
+	// split into chunks at line boundaries, small files are parsed in one
+	std::size_t N_chunks = file.size() < (1 << 20) ? 1 :
+		std::max(1u, std::thread::hardware_concurrency());
+	std::vector<const char*> bounds{data};
+	for(std::size_t k = 1; k < N_chunks; ++k){
+		const char* p = std::max(bounds.back(), data + k * file.size() / N_chunks);
+		while(p < dataEnd && *p != '\n'){++p;}
+		bounds.push_back(std::min(p + 1, dataEnd));
+	}
+	bounds.push_back(dataEnd);
+	std::vector<std::future<std::vector<double>>> chunkValues;
+	for(std::size_t k = 0; k + 1 < bounds.size(); ++k){
+		chunkValues.emplace_back(std::async(std::launch::async,
+			parseObstacleLines, bounds[k], bounds[k+1]));
+	}
+	for(auto& chunk : chunkValues){
+		std::vector<double> values = chunk.get();
+		addObstacles(values.data(), values.size() / 4);
+	}
+	buildObstacleGrid();
 }
 
 void Environment::printItem(std::ofstream& os) const{
@@ -49,11 +340,18 @@ double Environment::getMaxDistance() const{
 
 void Environment::generateRandomObstacles(const int N_obstacles,
 		const double sizeBound){
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	generateRandomObstacles(N_obstacles, sizeBound, gen);
+}
+
+void Environment::generateRandomObstacles(const int N_obstacles,
+		const double sizeBound, std::mt19937& gen){
 	for(int i = 1; i<= N_obstacles; i++){
 		std::shared_ptr<Obstacle> newOb =
 			std::make_shared<Obstacle>();
-		newOb->genRandom(deltaX, deltaY, sizeBound);
-		obstacleList.push_back(newOb);
+		newOb->genRandom(deltaX, deltaY, sizeBound, gen);
+		addObstacle(newOb);
 	}
 }
 
@@ -119,6 +417,11 @@ void Obstacle::printItem(std::ofstream& os) const{
 void Obstacle::genRandom(const double xMax, const double yMax,const double sizeBound){
 	std::random_device rd;
 	std::mt19937 gen(rd());
+	genRandom(xMax, yMax, sizeBound, gen);
+}
+
+void Obstacle::genRandom(const double xMax, const double yMax,const double sizeBound,
+		std::mt19937& gen){
 	double lower_bound = 0;
 	std::uniform_real_distribution<> xDistribution(lower_bound,xMax);
 	std::uniform_real_distribution<> yDistribution(lower_bound,yMax);
@@ -174,6 +477,10 @@ double Point::calculateCost(const std::shared_ptr<Point> p) const{
 void Point::genRandom(const Environment& env){
 	std::random_device rd; //Get random seed
 	std::mt19937 gen(rd()); //mersenne_twister_engine seeded with rd()
+	genRandom(env, gen);
+}
+
+void Point::genRandom(const Environment& env, std::mt19937& gen){
 	double lower_bound = 0;
 	std::uniform_real_distribution<> xDistribution(lower_bound, env.getDeltaX());
 	std::uniform_real_distribution<> yDistribution(lower_bound, env.getDeltaY());
@@ -222,26 +529,8 @@ void Line::setPoints(std::shared_ptr<Point> p1_in, std::shared_ptr<Point> p2_in)
 	p2 = p2_in;
 }
 bool Line::intersectCheck(std::shared_ptr<Line> line_check) const{
-	bool intersect = false;
-	double x1 = p1->getX();
-	double x2 = p2->getX();
-	double y1 = p1->getY();
-	double y2 = p2->getY();
-	
 	std::shared_ptr<Point> p3 = line_check->getPoint1();
 	std::shared_ptr<Point> p4 = line_check->getPoint2();
-	double x3 = p3->getX();
-	double x4 = p4->getX();
-	double y3 = p3->getY();
-	double y4 = p4->getY();
-	
-	double check1 = ((x4-x3)*(y1-y3) - (y4-y3)*(x1-x3)) /
-		((y4-y3)*(x2-x1) - (x4-x3)*(y2-y1));
-	double check2 = ((x2-x1)*(y1-y3) - (y2-y1)*(x1-x3)) /
-		((y4-y3)*(x2-x1) - (x4-x3)*(y2-y1));
-	
-	if(check1 >= 0 && check1 <= 1 && check2 >= 0 && check2 <= 1){
-		intersect = true;	
-	}
-	return intersect;	
+	return segmentsIntersect(p1->getX(), p1->getY(), p2->getX(), p2->getY(),
+			p3->getX(), p3->getY(), p4->getX(), p4->getY());
 }
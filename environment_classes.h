@@ -1,23 +1,61 @@
 #ifndef ENVIRONMENT_CLASSES_H
 #define ENVIRONMENT_CLASSES_H
 #include "std_lib_facilities.h"
+#include <random>
+#include <cstdint>
 
 class Obstacle;
 class Point;
 class Environment;
 class Line;
 
+// Obstacles are kept in flat storage (one array per parameter) rather than
+// as Obstacle objects, together with a uniform grid that lists the obstacles
+// overlapping each cell, so that point and segment queries only test nearby
+// obstacles. The grid is built by buildObstacleGrid (the bulk loaders and
+// RRT_star do this); until then, and after addObstacle, queries test every
+// obstacle.
 class Environment{
 	double deltaX = 0; //size in the x direction
 	double deltaY = 0; //size in the y direction
-	std::vector<std::shared_ptr<Obstacle>> obstacleList; // list of obstacles in the environment
+	// obstacles in the environment, top left corner (x,y) and size (dx,dy)
+	std::vector<double> obstacleX;
+	std::vector<double> obstacleY;
+	std::vector<double> obstacleDX;
+	std::vector<double> obstacleDY;
+	// obstacle grid, cell c lists gridObstacles[gridCellStart[c]] up to
+	// gridObstacles[gridCellStart[c+1]], cells are numbered row by row
+	bool gridValid = false;
+	double gridCellSize = 1;
+	int gridNX = 0;
+	int gridNY = 0;
+	std::vector<std::uint32_t> gridCellStart;
+	std::vector<std::uint32_t> gridObstacles;
+
+	int gridColumn(const double px) const; // clamped grid column/row of a coordinate
+	int gridRow(const double py) const;
+	bool pointFreeOf(const std::uint32_t i, const double px, const double py) const;
+	bool segmentHits(const std::uint32_t i, const double x1, const double y1,
+			const double x2, const double y2) const; // segment crosses an edge of obstacle i
 	public:
 		// constructor
 		Environment(double setdeltaX, double setdeltaY);
 		// member functions
 		void addObstacle(std::shared_ptr<Obstacle> obs); // Add a single obstacle to the environment
-		std::vector<std::shared_ptr<Obstacle>> getObstacleList() const; // return vector with obstacles
+		void addObstacles(const double* values, const std::size_t N_obstacles); // bulk add, values holds x,y,dx,dy for each obstacle
+		std::vector<std::shared_ptr<Obstacle>> getObstacleList() const; // return vector with (newly constructed) obstacles
+		std::size_t getNumObstacles() const;
+		const double* getObstacleX() const; // flat obstacle storage, getNumObstacles() values each
+		const double* getObstacleY() const;
+		const double* getObstacleDX() const;
+		const double* getObstacleDY() const;
 		bool obstacleFree(std::shared_ptr<Point> p) const; // check if a point is in an obstacle free region
+		bool pointFree(const double px, const double py) const;
+		// segment between (x1,y1) and (x2,y2) has both ends obstacle free and
+		// crosses no obstacle edge; p_obstacleTests, if given, is increased by
+		// the number of obstacles tested
+		bool segmentFree(const double x1, const double y1, const double x2,
+				const double y2, std::uint64_t* p_obstacleTests = nullptr) const;
 		double getDeltaX() const;
 		double getDeltaY() const;
 
@@ -26,6 +64,21 @@ class Environment{
 
 		void generateRandomObstacles(const int N_obstacles,
 				const double sizeBound);
+		void generateRandomObstacles(const int N_obstacles,
+				const double sizeBound, std::mt19937& gen); // reproducible version, draws from gen
+
+		// (Re)builds the obstacle grid, cellSize <= 0 picks a size from the
+		// obstacle density
+		void buildObstacleGrid(double cellSize = 0);
+		bool hasObstacleGrid() const;
+
+		// Bulk obstacle loaders, append to the environment and build the
+		// obstacle grid. Both memory map the file; the CSV loader (same format
+		// as Obstacle::printItem, x,y,dx,dy per line) parses chunks of the file
+		// in parallel. Throw std::runtime_error on malformed input.
+		void loadObstaclesBinary(const std::string& filename);
+		void loadObstaclesCSV(const std::string& filename);
+		void writeObstaclesBinary(const std::string& filename) const;
 };
 class Obstacle{
 	protected:
@@ -53,6 +106,8 @@ class Obstacle{
 		void printItem(std::ofstream& os) const;
 		void genRandom(const double xMax, const double yMax,
 				const double sizeBound);
+		void genRandom(const double xMax, const double yMax,
+				const double sizeBound, std::mt19937& gen);
 };
 class Point{
 	protected:
@@ -65,6 +120,7 @@ class Point{
 
 		// member functions
 		void genRandom(const Environment& env);
+		void genRandom(const Environment& env, std::mt19937& gen); // reproducible version, draws from gen
 		double getX() const; // get x point
 		double getY() const; // get y point
 		void setX(double xSet); // set x coordinate
@@ -0,0 +1,42 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& filename){
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0){
+		throw std::runtime_error("Unable to open " + filename);
+	}
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0){
+		close(fd);
+		throw std::runtime_error("Unable to stat " + filename);
+	}
+	length = fileInfo.st_size;
+	if(length > 0){
+		void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p == MAP_FAILED){
+			close(fd);
+			throw std::runtime_error("Unable to map " + filename);
+		}
+		madvise(p, length, MADV_SEQUENTIAL);
+		data_p = static_cast<const char*>(p);
+	}
+	close(fd); // the mapping stays valid after the descriptor is closed
+}
+
+MappedFile::~MappedFile(){
+	if(data_p != nullptr){
+		munmap(const_cast<char*>(data_p), length);
+	}
+}
+
+const char* MappedFile::data() const{
+	return data_p;
+}
+
+std::size_t MappedFile::size() const{
+	return length;
+}
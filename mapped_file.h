@@ -0,0 +1,19 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include "std_lib_facilities.h"
+
+// Read-only memory map of a whole file, unmapped on destruction
+// Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile{
+	const char* data_p = nullptr;
+	std::size_t length = 0;
+	public:
+		MappedFile(const std::string& filename);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		const char* data() const;
+		std::size_t size() const;
+};
+
+#endif
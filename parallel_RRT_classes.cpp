@@ -0,0 +1,186 @@
+#ifndef PARALLEL_RRT_CPP
+#define PARALLEL_RRT_CPP
+#include "parallel_RRT_classes.h"
+
+template<typename T>
+ParallelRRT_star<T>::ParallelRRT_star(int N_planners, int N,
+		const Environment& env_input, Obstacle& goal_in, T& start_in){
+	auto envCopy = std::make_shared<Environment>(env_input);
+	if(!envCopy->hasObstacleGrid()){
+		envCopy->buildObstacleGrid();
+	}
+	env = envCopy;
+	assert(N_planners > 0);
+	sharedBestCost = std::make_shared<std::atomic<double>>(
+			std::numeric_limits<double>::infinity());
+	for(int k = 0; k < N_planners; ++k){
+		planners.push_back(std::make_unique<RRT_star<T>>(N, env, goal_in, start_in));
+		planners.back()->setSharedCostBound(sharedBestCost);
+	}
+}
+
+template<typename T>
+ParallelRRT_star<T>::ParallelRRT_star(int N_planners, int N,
+		std::shared_ptr<const Environment> env_input, Obstacle& goal_in,
+		T& start_in){
+	env = env_input;
+	assert(N_planners > 0);
+	sharedBestCost = std::make_shared<std::atomic<double>>(
+			std::numeric_limits<double>::infinity());
+	for(int k = 0; k < N_planners; ++k){
+		planners.push_back(std::make_unique<RRT_star<T>>(N, env, goal_in, start_in));
+		planners.back()->setSharedCostBound(sharedBestCost);
+	}
+}
+
+template<typename T>
+void ParallelRRT_star<T>::setSeed(unsigned int seed){
+	for(std::size_t k = 0; k < planners.size(); ++k){
+		planners[k]->setSeed(seed + k);
+	}
+}
+
+template<typename T>
+void ParallelRRT_star<T>::setCostTarget(const double target){
+	costTarget = target;
+}
+
+template<typename T>
+void ParallelRRT_star<T>::setTimeBudget(const double seconds){
+	timeBudget = seconds;
+}
+
+template<typename T>
+void ParallelRRT_star<T>::setMemoryBudget(const std::size_t bytes){
+	for(auto& p_planner : planners){
+		p_planner->setMemoryBudget(bytes / planners.size());
+	}
+}
+
+template<typename T>
+void ParallelRRT_star<T>::runPlanner(const std::size_t k, const double radius,
+		const std::chrono::steady_clock::time_point deadline){
+	RRT_star<T>& planner = *planners[k];
+	planner.initializeTree();
+	// same stopping point as RRT_star::initiate: N_points-1 iterations since
+	// the tree was started, so a repeated initiate only continues a run that
+	// stopped early (time budget, cost target)
+	for(int i = 1; planner.getIterations() + 1 < std::uint64_t(planner.getNumPoints()); i++){
+		if(stopping.load(std::memory_order_relaxed)){
+			return;
+		}
+		try{
+			planner.iterate(radius);
+		}
+		catch(...){
+			// handed to initiate, an exception leaving a thread terminates
+			plannerErrors[k] = std::current_exception();
+			stopping.store(true, std::memory_order_relaxed);
+			return;
+		}
+		if(sharedBestCost->load(std::memory_order_relaxed) <= costTarget){
+			stopping.store(true, std::memory_order_relaxed);
+			return;
+		}
+		// reading the clock every iteration would cost more than the
+		// cheap early iterations themselves
+		if((i & 63) == 0 && std::chrono::steady_clock::now() >= deadline){
+			stopping.store(true, std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+template<typename T>
+void ParallelRRT_star<T>::initiate(double radius){
+	auto startTime = std::chrono::steady_clock::now();
+	auto deadline = std::chrono::steady_clock::time_point::max();
+	if(timeBudget < std::numeric_limits<double>::infinity()){
+		deadline = startTime + std::chrono::duration_cast<
+			std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(timeBudget));
+	}
+	stopping.store(false, std::memory_order_relaxed);
+	plannerErrors.assign(planners.size(), nullptr);
+
+	// planner 0 runs on the calling thread
+	std::vector<std::thread> threads;
+	for(std::size_t k = 1; k < planners.size(); ++k){
+		threads.emplace_back(&ParallelRRT_star<T>::runPlanner, this, k, radius,
+				deadline);
+	}
+	runPlanner(0, radius, deadline);
+	for(auto& t : threads){
+		t.join();
+	}
+	elapsed = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	for(const auto& error : plannerErrors){
+		if(error){
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+template<typename T>
+bool ParallelRRT_star<T>::pathFound() const{
+	for(const auto& p_planner : planners){
+		if(p_planner->pathFound()){
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T>
+double ParallelRRT_star<T>::getBestCost() const{
+	double bestCost = std::numeric_limits<double>::infinity();
+	for(const auto& p_planner : planners){
+		bestCost = std::min(bestCost, p_planner->getBestCost());
+	}
+	return bestCost;
+}
+
+template<typename T>
+double ParallelRRT_star<T>::getElapsed() const{
+	return elapsed;
+}
+
+template<typename T>
+std::size_t ParallelRRT_star<T>::getNumPlanners() const{
+	return planners.size();
+}
+
+template<typename T>
+RRT_star<T>& ParallelRRT_star<T>::getPlanner(const std::size_t k){
+	assert(k < planners.size());
+	return *planners[k];
+}
+
+template<typename T>
+RRT_star<T>& ParallelRRT_star<T>::getBestPlanner(){
+	std::size_t best = 0;
+	for(std::size_t k = 1; k < planners.size(); ++k){
+		if(planners[k]->getBestCost() < planners[best]->getBestCost()){
+			best = k;
+		}
+	}
+	return *planners[best];
+}
+
+template<typename T>
+TreeAncestorPath<T> ParallelRRT_star<T>::getFinalPath(){
+	assert(pathFound());
+	return getBestPlanner().getFinalPath();
+}
+
+template<typename T>
+RRT_stats ParallelRRT_star<T>::getStats() const{
+	RRT_stats total;
+	for(const auto& p_planner : planners){
+		total += p_planner->getStats();
+	}
+	return total;
+}
+
+#endif
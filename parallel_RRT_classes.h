@@ -0,0 +1,58 @@
+#ifndef PARALLEL_RRT_H_INCLUDED
+#define PARALLEL_RRT_H_INCLUDED
+#include "RRT_classes.h"
+#include <chrono>
+#include <exception>
+#include <limits>
+
+// OR-parallel RRT*: M independently seeded RRT_star planners, one per thread,
+// searching the same read-only Environment
+// The time to a first solution depends a lot on sampling luck, running
+// several trees and keeping the best one cuts the long tail on hard maps.
+// The planners share their best path cost through an atomic bound (see
+// RRT_star::setSharedCostBound): once any planner finds a path, the others
+// stop adding nodes that already cost more than it. The run stops when a
+// path reaches the cost target, the time budget runs out or every planner
+// has done its N iterations; the best path of all planners is returned.
+//
+// Requirements of the template T type/class: same as RRT_star
+template<typename T>
+class ParallelRRT_star{
+	protected:
+		std::shared_ptr<const Environment> env; // shared by all planners
+		std::vector<std::unique_ptr<RRT_star<T>>> planners;
+		std::shared_ptr<std::atomic<double>> sharedBestCost;
+		std::atomic<bool> stopping{false};
+		double costTarget = 0; // stop when a path at most this cost is found, 0 = never
+		double timeBudget = std::numeric_limits<double>::infinity(); // seconds
+		double elapsed = 0; // seconds spent in the last initiate
+		std::vector<std::exception_ptr> plannerErrors; // exception of each planner in the last initiate
+
+		void runPlanner(const std::size_t k, const double radius,
+				const std::chrono::steady_clock::time_point deadline);
+	public:
+		ParallelRRT_star(int N_planners, int N, const Environment& env_input,
+				Obstacle& goal_in, T& start_in);
+		ParallelRRT_star(int N_planners, int N,
+				std::shared_ptr<const Environment> env_input,
+				Obstacle& goal_in, T& start_in);
+
+		void setSeed(unsigned int seed); // planner k is seeded with seed + k
+		void setCostTarget(const double target);
+		void setTimeBudget(const double seconds);
+		// total memory budget, split evenly between the planners (see
+		// RRT_star::setMemoryBudget)
+		void setMemoryBudget(const std::size_t bytes);
+
+		void initiate(double radius); // runs all planners until a stopping criterion is met (at most N-1 iterations per tree in total, as RRT_star::initiate), rethrows the first planner exception
+		bool pathFound() const;
+		double getBestCost() const; // infinity if no planner found a path
+		double getElapsed() const; // wall clock seconds of the last initiate
+		std::size_t getNumPlanners() const;
+		RRT_star<T>& getPlanner(const std::size_t k);
+		RRT_star<T>& getBestPlanner(); // planner holding the lowest cost path
+		TreeAncestorPath<T> getFinalPath(); // best path of all planners
+		RRT_stats getStats() const; // counters summed over the planners
+};
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef PATH_PROCESSING_CPP
+#define PATH_PROCESSING_CPP
+#include "path_processing.h"
+
+template<typename T>
+PathShortcutter<T>::PathShortcutter(const Environment& env_in, const double timeBudget_in){
+	auto envCopy = std::make_shared<Environment>(env_in);
+	if(!envCopy->hasObstacleGrid()){
+		envCopy->buildObstacleGrid();
+	}
+	env = envCopy;
+	timeBudget = timeBudget_in;
+}
+
+template<typename T>
+PathShortcutter<T>::PathShortcutter(std::shared_ptr<const Environment> env_in,
+		const double timeBudget_in){
+	env = env_in;
+	timeBudget = timeBudget_in;
+}
+
+template<typename T>
+void PathShortcutter<T>::setSeed(unsigned int seed){
+	gen.seed(seed);
+}
+
+template<typename T>
+void PathShortcutter<T>::setThreads(const int N){
+	N_threads = std::max(N, 1);
+}
+
+template<typename T>
+void PathShortcutter<T>::checkSegments(const std::vector<double>& coords,
+		std::vector<char>& result) const{
+	std::size_t N = coords.size() / 4;
+	result.assign(N, 0);
+	auto worker = [this, &coords, &result](std::size_t begin, std::size_t end){
+		for(std::size_t k = begin; k < end; ++k){
+			result[k] = env->segmentFree(coords[4*k], coords[4*k+1],
+					coords[4*k+2], coords[4*k+3]);
+		}
+	};
+	// small batches are not worth the thread start up
+	std::size_t N_tasks = N < 64 ? 1 : std::min<std::size_t>(N_threads, N / 32);
+	std::vector<std::future<void>> futures;
+	for(std::size_t t = 1; t < N_tasks; ++t){
+		futures.emplace_back(std::async(std::launch::async, worker,
+				t * N / N_tasks, (t+1) * N / N_tasks));
+	}
+	worker(0, N / N_tasks);
+	for(auto& f : futures){
+		f.get();
+	}
+}
+
+template<typename T>
+std::vector<std::shared_ptr<T>> PathShortcutter<T>::shortcut(const TreeAncestorPath<T>& path){
+	std::vector<std::shared_ptr<T>> waypoints;
+	waypoints.reserve(path.getPath().size());
+	for(const auto& p_node : path.getPath()){
+		waypoints.push_back(p_node->getItem());
+	}
+	return shortcut(waypoints);
+}
+
+template<typename T>
+std::vector<std::shared_ptr<T>> PathShortcutter<T>::shortcut(std::vector<std::shared_ptr<T>> waypoints){
+	auto deadline = std::chrono::steady_clock::now() +
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(timeBudget));
+	greedyShortcut(waypoints, deadline);
+	randomShortcut(waypoints, deadline);
+	return waypoints;
+}
+
+// From waypoint i, the candidates i+2 ... n-1 are checked farthest first, one
+// batch at a time, and the path jumps to the farthest free one
+template<typename T>
+void PathShortcutter<T>::greedyShortcut(std::vector<std::shared_ptr<T>>& waypoints,
+		const std::chrono::steady_clock::time_point deadline) const{
+	std::size_t n = waypoints.size();
+	if(n < 3){
+		return;
+	}
+	std::vector<std::shared_ptr<T>> result{waypoints[0]};
+	std::vector<double> coords;
+	std::vector<char> free;
+	std::size_t i = 0;
+	while(i < n - 1){
+		if(std::chrono::steady_clock::now() > deadline){ // out of time, keep the rest
+			result.insert(result.end(), waypoints.begin() + i + 1, waypoints.end());
+			break;
+		}
+		std::size_t next = i + 1;
+		std::size_t blockEnd = n - 1;
+		while(blockEnd >= i + 2 && next == i + 1){
+			std::size_t blockStart = blockEnd + 1 - std::min(batchSize, blockEnd - i - 1);
+			coords.clear();
+			for(std::size_t j = blockEnd + 1; j-- > blockStart;){
+				coords.insert(coords.end(), {waypoints[i]->getX(),
+					waypoints[i]->getY(), waypoints[j]->getX(),
+					waypoints[j]->getY()});
+			}
+			checkSegments(coords, free);
+			for(std::size_t k = 0; k < free.size(); ++k){
+				if(free[k]){
+					next = blockEnd - k;
+					break;
+				}
+			}
+			blockEnd = blockStart - 1;
+		}
+		result.push_back(waypoints[next]);
+		i = next;
+	}
+	waypoints.swap(result);
+}
+
+// Random shortcuts between points along the path, described by their arc
+// length position s. A batch of candidates is checked at once, then the free
+// ones are applied greedily by length saved, skipping any that overlap an
+// already applied one.
+template<typename T>
+void PathShortcutter<T>::randomShortcut(std::vector<std::shared_ptr<T>>& waypoints,
+		const std::chrono::steady_clock::time_point deadline){
+	struct Candidate{
+		double s1, s2; // arc length positions, s1 < s2
+		std::size_t a, b; // segments containing s1 and s2
+		double x1, y1, x2, y2;
+		double gain; // path length saved
+	};
+	const int maxIdleRounds = 5; // rounds without any improvement before stopping
+	std::vector<double> arcLength;
+	std::vector<Candidate> candidates;
+	std::vector<double> coords;
+	std::vector<char> free;
+	int idleRounds = 0;
+	while(waypoints.size() >= 3 && idleRounds < maxIdleRounds &&
+			std::chrono::steady_clock::now() < deadline){
+		arcLength.assign(1, 0.0);
+		for(std::size_t k = 1; k < waypoints.size(); ++k){
+			arcLength.push_back(arcLength.back() +
+				waypoints[k]->calculateDistance(waypoints[k-1]));
+		}
+		double total = arcLength.back();
+		std::uniform_real_distribution<> positionDistribution(0, total);
+		// position s on segment k, from waypoint k to k+1
+		auto locate = [&](double s, std::size_t& k, double& x, double& y){
+			k = std::upper_bound(arcLength.begin(), arcLength.end(), s)
+				- arcLength.begin() - 1;
+			k = std::min(k, waypoints.size() - 2);
+			double segLength = arcLength[k+1] - arcLength[k];
+			double t = segLength > 0 ? (s - arcLength[k]) / segLength : 0;
+			x = waypoints[k]->getX() + t * (waypoints[k+1]->getX() - waypoints[k]->getX());
+			y = waypoints[k]->getY() + t * (waypoints[k+1]->getY() - waypoints[k]->getY());
+		};
+
+		candidates.clear();
+		coords.clear();
+		for(std::size_t k = 0; k < batchSize; ++k){
+			Candidate c;
+			c.s1 = positionDistribution(gen);
+			c.s2 = positionDistribution(gen);
+			if(c.s1 > c.s2){std::swap(c.s1, c.s2);}
+			locate(c.s1, c.a, c.x1, c.y1);
+			locate(c.s2, c.b, c.x2, c.y2);
+			if(c.a == c.b){continue;} // same straight segment, nothing to gain
+			c.gain = (c.s2 - c.s1) - std::sqrt((c.x2-c.x1)*(c.x2-c.x1) +
+					(c.y2-c.y1)*(c.y2-c.y1));
+			if(c.gain <= 1e-9 * total){continue;}
+			candidates.push_back(c);
+			coords.insert(coords.end(), {c.x1, c.y1, c.x2, c.y2});
+		}
+		checkSegments(coords, free);
+
+		std::vector<Candidate> applied;
+		std::vector<std::size_t> order(candidates.size());
+		for(std::size_t k = 0; k < order.size(); ++k){order[k] = k;}
+		std::sort(order.begin(), order.end(), [&](std::size_t l, std::size_t r){
+			return candidates[l].gain > candidates[r].gain;});
+		for(auto k : order){
+			const Candidate& c = candidates[k];
+			if(!free[k]){continue;}
+			bool overlaps = false;
+			for(const auto& other : applied){
+				if(c.s1 < other.s2 && other.s1 < c.s2){
+					overlaps = true;
+					break;
+				}
+			}
+			if(!overlaps){
+				applied.push_back(c);
+			}
+		}
+		if(applied.empty()){
+			++idleRounds;
+			continue;
+		}
+		idleRounds = 0;
+		// apply from the end of the path so that earlier segment indices
+		// stay valid: waypoints a+1 ... b are replaced by the two end points
+		std::sort(applied.begin(), applied.end(), [](const Candidate& l,
+			const Candidate& r){return l.s1 > r.s1;});
+		for(const auto& c : applied){
+			waypoints.erase(waypoints.begin() + c.a + 1, waypoints.begin() + c.b + 1);
+			waypoints.insert(waypoints.begin() + c.a + 1,
+				{std::make_shared<T>(c.x1, c.y1), std::make_shared<T>(c.x2, c.y2)});
+		}
+	}
+}
+
+template<typename T>
+double PathShortcutter<T>::pathLength(const std::vector<std::shared_ptr<T>>& waypoints){
+	double length = 0;
+	for(std::size_t k = 1; k < waypoints.size(); ++k){
+		length += waypoints[k]->calculateDistance(waypoints[k-1]);
+	}
+	return length;
+}
+
+template<typename T>
+void PathShortcutter<T>::printPath(const std::vector<std::shared_ptr<T>>& waypoints,
+		std::ofstream& os){
+	for(const auto& p_item : waypoints){
+		p_item->printItem(os);
+	}
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef PATH_PROCESSING_H
+#define PATH_PROCESSING_H
+#include "std_lib_facilities.h"
+#include "tree_classes.h"
+#include "environment_classes.h"
+#include <chrono>
+#include <random>
+
+// Post-processing of paths returned by RRT_star::getFinalPath
+// PathShortcutter removes the zig-zag of the fixed steering steps by
+// replacing parts of the path with straight, collision free segments, using
+// the same collision test as RRT_star (Environment::segmentFree). It runs two
+// stages within a time budget:
+// 1) greedy shortcutting: from each waypoint, jump to the farthest later
+// waypoint that can be reached in a straight line
+// 2) randomised shortcutting: connect random points along the path (not only
+// waypoints, which also cuts corners) and keep the non-overlapping
+// shortcuts that shorten the path, until the budget runs out or several
+// rounds in a row bring no improvement
+// Candidate segments are collision checked in batches split across threads.
+//
+// Requirements of the template T type/class: getX()/getY() and T(x,y)
+template<typename T>
+class PathShortcutter{
+	protected:
+		std::shared_ptr<const Environment> env;
+		double timeBudget = 0.05; // seconds
+		int N_threads = 8;
+		std::size_t batchSize = 256; // candidate segments checked per batch
+		std::mt19937 gen{std::random_device{}()};
+
+		// coords holds x1,y1,x2,y2 for each segment, result[k] is set to 1
+		// when segment k is collision free
+		void checkSegments(const std::vector<double>& coords,
+				std::vector<char>& result) const;
+		void greedyShortcut(std::vector<std::shared_ptr<T>>& waypoints,
+				const std::chrono::steady_clock::time_point deadline) const;
+		void randomShortcut(std::vector<std::shared_ptr<T>>& waypoints,
+				const std::chrono::steady_clock::time_point deadline);
+	public:
+		PathShortcutter(const Environment& env_in, const double timeBudget_in);
+		PathShortcutter(std::shared_ptr<const Environment> env_in,
+				const double timeBudget_in);
+		void setSeed(unsigned int seed);
+		void setThreads(const int N);
+
+		std::vector<std::shared_ptr<T>> shortcut(const TreeAncestorPath<T>& path);
+		std::vector<std::shared_ptr<T>> shortcut(std::vector<std::shared_ptr<T>> waypoints);
+
+		static double pathLength(const std::vector<std::shared_ptr<T>>& waypoints);
+		static void printPath(const std::vector<std::shared_ptr<T>>& waypoints,
+				std::ofstream& os);
+};
+
+#endif
@@ -1,4 +1,5 @@
 import csv
+import os
 from matplotlib import pyplot as plt
 import numpy as np
 
@@ -8,6 +9,7 @@ obstacleList = list()
 nodeListFile = 'nodesSampled_RRTstar.csv'
 optimalPathFile = 'optimalPath_RRTstar.csv'
 obstacleFile = 'obstacles.csv'
+shortcutPathFile = 'shortcutPath_RRTstar.csv'
 
 environmentFile = 'environment.csv'
 
@@ -53,6 +55,16 @@ plt.figure(figsize=(16,16))
 # plot optimal path
 plt.plot(x_optimalPath,y_optimalPath,'b-*',linewidth=3)
 
+# plot shortcut path, if the C++ post-processing wrote one
+if os.path.exists(shortcutPathFile):
+    shortcutPath = list()
+    with open(shortcutPathFile) as csv_file:
+        csv_reader = csv.reader(csv_file, delimiter = ',')
+        for row in csv_reader:
+            shortcutPath.append((float(row[0]),float(row[1])))
+    x_shortcutPath, y_shortcutPath = zip(*shortcutPath)
+    plt.plot(x_shortcutPath,y_shortcutPath,'g-o',linewidth=3)
+
 # plot sampled nodes
 plt.plot(x_nodeList,y_nodeList,'r.')
 
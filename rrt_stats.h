@@ -0,0 +1,208 @@
+#ifndef RRT_STATS_H
+#define RRT_STATS_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hot-path instrumentation for RRT_star
+// Counters and per-phase cycle timers are only compiled in when
+// RRT_ENABLE_STATS is defined (e.g. -DRRT_ENABLE_STATS, or #define before
+// including RRT_classes.h); otherwise the RRT_STAT_* macros expand to nothing
+// and RRT_star::getStats() returns zeros.
+//
+// Each RRT_star owns its counters and only the thread running the planner
+// writes them (relaxed load + store, no read-modify-write), so there is no
+// contention between planners running on different threads. Other threads
+// may call getStats() during a run and get a consistent-enough snapshot.
+//
+// Cycles are read with rdtsc on x86 and fall back to steady_clock
+// nanoseconds elsewhere.
+
+// Snapshot of the counters, returned by RRT_star::getStats()
+struct RRT_stats{
+	std::uint64_t iterations = 0; // calls to extend
+	std::uint64_t extendSuccesses = 0; // extends that added a node
+	std::uint64_t collisionChecks = 0; // calls to collisionCheck
+	std::uint64_t obstacleTests = 0; // obstacle/segment intersection tests
+	std::uint64_t nearQueries = 0; // near node searches
+	std::uint64_t nearNodesTotal = 0; // sum of near node set sizes
+	std::uint64_t nearNodesMax = 0; // largest near node set
+	std::uint64_t rewires = 0; // near nodes rewired through a new node
+	std::uint64_t prunedNodes = 0; // new nodes dropped against the own best path (setCostToGo) or a shared cost bound
+	std::uint64_t rejectedSamples = 0; // samples drawn inside an obstacle and redrawn
+	std::uint64_t evictedNodes = 0; // leaves removed to stay within the memory budget
+	std::uint64_t clearanceAccepts = 0; // collision checks settled by the distance field
+
+	// cycles spent per phase, collision overlaps parentSelection and rewire
+	std::uint64_t samplingCycles = 0;
+	std::uint64_t nearestCycles = 0; // nearest search and steering
+	std::uint64_t nearCycles = 0;
+	std::uint64_t parentSelectionCycles = 0;
+	std::uint64_t rewireCycles = 0;
+	std::uint64_t collisionCycles = 0;
+
+	// sums the counters of several planners (nearNodesMax takes the maximum)
+	RRT_stats& operator+=(const RRT_stats& other){
+		iterations += other.iterations;
+		extendSuccesses += other.extendSuccesses;
+		collisionChecks += other.collisionChecks;
+		obstacleTests += other.obstacleTests;
+		nearQueries += other.nearQueries;
+		nearNodesTotal += other.nearNodesTotal;
+		nearNodesMax = std::max(nearNodesMax, other.nearNodesMax);
+		rewires += other.rewires;
+		prunedNodes += other.prunedNodes;
+		rejectedSamples += other.rejectedSamples;
+		evictedNodes += other.evictedNodes;
+		clearanceAccepts += other.clearanceAccepts;
+		samplingCycles += other.samplingCycles;
+		nearestCycles += other.nearestCycles;
+		nearCycles += other.nearCycles;
+		parentSelectionCycles += other.parentSelectionCycles;
+		rewireCycles += other.rewireCycles;
+		collisionCycles += other.collisionCycles;
+		return *this;
+	}
+
+	// counters as text, for checkpoints
+	void save(std::ostream& os) const{
+		os << iterations << ' ';
+		os << extendSuccesses << ' ';
+		os << collisionChecks << ' ';
+		os << obstacleTests << ' ';
+		os << nearQueries << ' ';
+		os << nearNodesTotal << ' ';
+		os << nearNodesMax << ' ';
+		os << rewires << ' ';
+		os << prunedNodes << ' ';
+		os << rejectedSamples << ' ';
+		os << evictedNodes << ' ';
+		os << clearanceAccepts << ' ';
+		os << samplingCycles << ' ';
+		os << nearestCycles << ' ';
+		os << nearCycles << ' ';
+		os << parentSelectionCycles << ' ';
+		os << rewireCycles << ' ';
+		os << collisionCycles << ' ';
+	}
+	void load(std::istream& is){
+		is >> iterations >> extendSuccesses >> collisionChecks >> obstacleTests
+			>> nearQueries >> nearNodesTotal >> nearNodesMax >> rewires
+			>> prunedNodes >> rejectedSamples >> evictedNodes >> clearanceAccepts
+			>> samplingCycles
+			>> nearestCycles >> nearCycles >> parentSelectionCycles
+			>> rewireCycles >> collisionCycles;
+	}
+};
+
+inline std::uint64_t readCycleCounter(){
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Live counters owned by one RRT_star, aligned so that planners on
+// different threads never share a cache line
+struct alignas(64) RRT_statCounters{
+	std::atomic<std::uint64_t> iterations{0};
+	std::atomic<std::uint64_t> extendSuccesses{0};
+	std::atomic<std::uint64_t> collisionChecks{0};
+	std::atomic<std::uint64_t> obstacleTests{0};
+	std::atomic<std::uint64_t> nearQueries{0};
+	std::atomic<std::uint64_t> nearNodesTotal{0};
+	std::atomic<std::uint64_t> nearNodesMax{0};
+	std::atomic<std::uint64_t> rewires{0};
+	std::atomic<std::uint64_t> prunedNodes{0};
+	std::atomic<std::uint64_t> rejectedSamples{0};
+	std::atomic<std::uint64_t> evictedNodes{0};
+	std::atomic<std::uint64_t> clearanceAccepts{0};
+	std::atomic<std::uint64_t> samplingCycles{0};
+	std::atomic<std::uint64_t> nearestCycles{0};
+	std::atomic<std::uint64_t> nearCycles{0};
+	std::atomic<std::uint64_t> parentSelectionCycles{0};
+	std::atomic<std::uint64_t> rewireCycles{0};
+	std::atomic<std::uint64_t> collisionCycles{0};
+
+	// single writer increment
+	static void add(std::atomic<std::uint64_t>& counter, std::uint64_t n){
+		counter.store(counter.load(std::memory_order_relaxed) + n,
+				std::memory_order_relaxed);
+	}
+	static void max(std::atomic<std::uint64_t>& counter, std::uint64_t n){
+		if(n > counter.load(std::memory_order_relaxed)){
+			counter.store(n, std::memory_order_relaxed);
+		}
+	}
+
+	// counters of a resumed run
+	void restore(const RRT_stats& s){
+		iterations.store(s.iterations, std::memory_order_relaxed);
+		extendSuccesses.store(s.extendSuccesses, std::memory_order_relaxed);
+		collisionChecks.store(s.collisionChecks, std::memory_order_relaxed);
+		obstacleTests.store(s.obstacleTests, std::memory_order_relaxed);
+		nearQueries.store(s.nearQueries, std::memory_order_relaxed);
+		nearNodesTotal.store(s.nearNodesTotal, std::memory_order_relaxed);
+		nearNodesMax.store(s.nearNodesMax, std::memory_order_relaxed);
+		rewires.store(s.rewires, std::memory_order_relaxed);
+		prunedNodes.store(s.prunedNodes, std::memory_order_relaxed);
+		rejectedSamples.store(s.rejectedSamples, std::memory_order_relaxed);
+		evictedNodes.store(s.evictedNodes, std::memory_order_relaxed);
+		clearanceAccepts.store(s.clearanceAccepts, std::memory_order_relaxed);
+		samplingCycles.store(s.samplingCycles, std::memory_order_relaxed);
+		nearestCycles.store(s.nearestCycles, std::memory_order_relaxed);
+		nearCycles.store(s.nearCycles, std::memory_order_relaxed);
+		parentSelectionCycles.store(s.parentSelectionCycles, std::memory_order_relaxed);
+		rewireCycles.store(s.rewireCycles, std::memory_order_relaxed);
+		collisionCycles.store(s.collisionCycles, std::memory_order_relaxed);
+	}
+
+	RRT_stats snapshot() const{
+		RRT_stats s;
+		s.iterations = iterations.load(std::memory_order_relaxed);
+		s.extendSuccesses = extendSuccesses.load(std::memory_order_relaxed);
+		s.collisionChecks = collisionChecks.load(std::memory_order_relaxed);
+		s.obstacleTests = obstacleTests.load(std::memory_order_relaxed);
+		s.nearQueries = nearQueries.load(std::memory_order_relaxed);
+		s.nearNodesTotal = nearNodesTotal.load(std::memory_order_relaxed);
+		s.nearNodesMax = nearNodesMax.load(std::memory_order_relaxed);
+		s.rewires = rewires.load(std::memory_order_relaxed);
+		s.prunedNodes = prunedNodes.load(std::memory_order_relaxed);
+		s.rejectedSamples = rejectedSamples.load(std::memory_order_relaxed);
+		s.evictedNodes = evictedNodes.load(std::memory_order_relaxed);
+		s.clearanceAccepts = clearanceAccepts.load(std::memory_order_relaxed);
+		s.samplingCycles = samplingCycles.load(std::memory_order_relaxed);
+		s.nearestCycles = nearestCycles.load(std::memory_order_relaxed);
+		s.nearCycles = nearCycles.load(std::memory_order_relaxed);
+		s.parentSelectionCycles = parentSelectionCycles.load(std::memory_order_relaxed);
+		s.rewireCycles = rewireCycles.load(std::memory_order_relaxed);
+		s.collisionCycles = collisionCycles.load(std::memory_order_relaxed);
+		return s;
+	}
+};
+
+#ifdef RRT_ENABLE_STATS
+// count n events in counter field of RRT_star::stats
+#define RRT_STAT_ADD(field, n) RRT_statCounters::add(stats.field, (n))
+#define RRT_STAT_MAX(field, n) RRT_statCounters::max(stats.field, (n))
+// start a lap timer, then add the cycles since the last lap to field
+#define RRT_STAT_TIMER(lap) std::uint64_t lap = readCycleCounter()
+#define RRT_STAT_LAP(lap, field) do{ std::uint64_t now_ = readCycleCounter(); \
+	RRT_statCounters::add(stats.field, now_ - lap); lap = now_; }while(0)
+#define RRT_STAT_RESTART(lap) lap = readCycleCounter()
+#else
+#define RRT_STAT_ADD(field, n) do{}while(0)
+#define RRT_STAT_MAX(field, n) do{}while(0)
+#define RRT_STAT_TIMER(lap) do{}while(0)
+#define RRT_STAT_LAP(lap, field) do{}while(0)
+#define RRT_STAT_RESTART(lap) do{}while(0)
+#endif
+
+#endif
@@ -0,0 +1,303 @@
+#include "sample_sources.h"
+#include <cstring>
+#include <limits>
+
+namespace{
+	// uniform double in [0,1) from 53 bits of two 32 bit draws
+	double uniformUnit(std::mt19937& gen){
+		std::uint32_t a = gen() >> 5;
+		std::uint32_t b = gen() >> 6;
+		return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+	}
+
+	// radical inverse of index in the given base, in [0,1]: the digits are
+	// reversed in integers and divided once by base^digits, so the only
+	// rounding is that of the conversions and the division (a running sum
+	// of digit * factor is contracted to FMA on some builds and not on
+	// others). Digits beyond 64 bits of denominator are below double
+	// resolution and dropped.
+	double radicalInverse(std::uint64_t index, const std::uint64_t base){
+		std::uint64_t reversed = 0;
+		std::uint64_t denominator = 1;
+		while(index > 0 && denominator <= std::numeric_limits<std::uint64_t>::max() / base){
+			reversed = reversed * base + index % base;
+			index /= base;
+			denominator *= base;
+		}
+		return double(reversed) / double(denominator);
+	}
+
+	// doubles are saved as their bit pattern, exact and locale independent
+	void saveDouble(std::ostream& os, const double value){
+		std::uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		os << bits << ' ';
+	}
+	double loadDouble(std::istream& is){
+		std::uint64_t bits = 0;
+		is >> bits;
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+	void checkState(const std::istream& is){
+		if(!is){
+			throw std::runtime_error("Invalid sample source state");
+		}
+	}
+}
+
+void SampleSource::fill(double* u, double* v, const std::size_t n){
+	for(std::size_t i = 0; i < n; ++i){
+		next(u[i], v[i]);
+	}
+}
+
+void SampleSource::saveState(std::ostream&){
+	throw std::runtime_error("Sample source state cannot be saved");
+}
+
+void SampleSource::loadState(std::istream&){
+	throw std::runtime_error("Sample source state cannot be loaded");
+}
+
+UniformSampleSource::UniformSampleSource(unsigned int seed) : gen(seed){
+}
+
+void UniformSampleSource::next(double& u, double& v){
+	u = uniformUnit(gen);
+	v = uniformUnit(gen);
+}
+
+void UniformSampleSource::saveState(std::ostream& os){
+	os << gen << ' ';
+}
+
+void UniformSampleSource::loadState(std::istream& is){
+	is >> gen;
+	checkState(is);
+}
+
+HaltonSampleSource::HaltonSampleSource(unsigned int seed, std::uint64_t skip){
+	index = skip;
+	if(seed != 0){
+		std::mt19937 gen(seed);
+		shiftU = uniformUnit(gen);
+		shiftV = uniformUnit(gen);
+	}
+}
+
+void HaltonSampleSource::next(double& u, double& v){
+	++index; // index 0 would give the corner (0,0)
+	u = radicalInverse(index, 2) + shiftU;
+	v = radicalInverse(index, 3) + shiftV;
+	if(u >= 1){u -= 1;}
+	if(v >= 1){v -= 1;}
+}
+
+void HaltonSampleSource::saveState(std::ostream& os){
+	os << index << ' ';
+	saveDouble(os, shiftU);
+	saveDouble(os, shiftV);
+}
+
+void HaltonSampleSource::loadState(std::istream& is){
+	is >> index;
+	shiftU = loadDouble(is);
+	shiftV = loadDouble(is);
+	checkState(is);
+}
+
+SobolSampleSource::SobolSampleSource(unsigned int seed){
+	// second dimension: primitive polynomial x + 1, m_1 = 1
+	directionV[0] = 1u << 31;
+	for(int k = 1; k < 32; ++k){
+		directionV[k] = directionV[k-1] ^ (directionV[k-1] >> 1);
+	}
+	if(seed != 0){
+		std::mt19937 gen(seed);
+		scrambleU = gen();
+		scrambleV = gen();
+	}
+}
+
+void SobolSampleSource::next(double& u, double& v){
+	// Gray code order: point i+1 differs from point i in the direction
+	// number of the lowest zero bit of i; point 0 (the corner) is skipped
+	int c = 0;
+	while((index >> c) & 1u){
+		++c;
+	}
+	++index;
+	assert(c < 32); // sequence exhausted after 2^32 - 1 points
+	stateU ^= 1u << (31 - c);
+	stateV ^= directionV[c];
+	u = (stateU ^ scrambleU) * (1.0 / 4294967296.0);
+	v = (stateV ^ scrambleV) * (1.0 / 4294967296.0);
+}
+
+void SobolSampleSource::saveState(std::ostream& os){
+	os << index << ' ' << stateU << ' ' << stateV << ' ' << scrambleU << ' '
+		<< scrambleV << ' ';
+}
+
+void SobolSampleSource::loadState(std::istream& is){
+	is >> index >> stateU >> stateV >> scrambleU >> scrambleV;
+	checkState(is);
+}
+
+StratifiedSampleSource::StratifiedSampleSource(const int nx_in, const int ny_in,
+		unsigned int seed) : gen(seed){
+	assert(nx_in > 0 && ny_in > 0);
+	nx = nx_in;
+	ny = ny_in;
+	cellOrder.resize(std::size_t(nx) * ny);
+	for(std::size_t c = 0; c < cellOrder.size(); ++c){
+		cellOrder[c] = c;
+	}
+	position = cellOrder.size(); // shuffle on the first sample
+}
+
+void StratifiedSampleSource::next(double& u, double& v){
+	if(position == cellOrder.size()){
+		// Fisher-Yates with the raw generator output (std::shuffle is not
+		// the same across standard libraries)
+		for(std::size_t i = cellOrder.size() - 1; i > 0; --i){
+			std::size_t j = std::size_t(uniformUnit(gen) * (i + 1));
+			std::swap(cellOrder[i], cellOrder[j]);
+		}
+		position = 0;
+	}
+	std::uint32_t cell = cellOrder[position++];
+	u = (cell % nx + uniformUnit(gen)) / nx;
+	v = (cell / nx + uniformUnit(gen)) / ny;
+}
+
+void StratifiedSampleSource::saveState(std::ostream& os){
+	os << gen << ' ' << nx << ' ' << ny << ' ' << position << ' ';
+	for(auto cell : cellOrder){
+		os << cell << ' ';
+	}
+}
+
+void StratifiedSampleSource::loadState(std::istream& is){
+	is >> gen >> nx >> ny >> position;
+	checkState(is);
+	if(nx <= 0 || ny <= 0 || position > std::size_t(nx) * ny){
+		throw std::runtime_error("Invalid sample source state");
+	}
+	cellOrder.resize(std::size_t(nx) * ny);
+	for(auto& cell : cellOrder){
+		is >> cell;
+	}
+	checkState(is);
+}
+
+FreeSpaceSampler::FreeSpaceSampler(std::shared_ptr<SampleSource> source_in,
+		std::shared_ptr<const Environment> env_in, const int maxAttempts_in){
+	assert(source_in != nullptr && env_in != nullptr);
+	assert(maxAttempts_in > 0);
+	source = source_in;
+	env = env_in;
+	maxAttempts = maxAttempts_in;
+}
+
+void FreeSpaceSampler::next(double& u, double& v){
+	for(int attempt = 1; ; ++attempt){
+		source->next(u, v);
+		if(attempt == maxAttempts ||
+				env->pointFree(u * env->getDeltaX(), v * env->getDeltaY())){
+			return;
+		}
+		++rejected;
+	}
+}
+
+std::uint64_t FreeSpaceSampler::getRejected() const{
+	return rejected;
+}
+
+void FreeSpaceSampler::saveState(std::ostream& os){
+	os << rejected << ' ';
+	source->saveState(os);
+}
+
+void FreeSpaceSampler::loadState(std::istream& is){
+	is >> rejected;
+	checkState(is);
+	source->loadState(is);
+}
+
+BufferedSampleSource::BufferedSampleSource(std::shared_ptr<SampleSource> source_in,
+		const std::size_t blockSize_in){
+	assert(source_in != nullptr);
+	source = source_in;
+	blockSize = std::max<std::size_t>(blockSize_in, 1);
+	frontU.resize(blockSize);
+	frontV.resize(blockSize);
+	backU.resize(blockSize);
+	backV.resize(blockSize);
+	source->fill(frontU.data(), frontV.data(), blockSize);
+	startFill();
+}
+
+BufferedSampleSource::~BufferedSampleSource(){
+	if(pending.valid()){
+		pending.wait();
+	}
+}
+
+void BufferedSampleSource::startFill(){
+	pending = std::async(std::launch::async, [this](){
+		source->fill(backU.data(), backV.data(), blockSize);
+	});
+}
+
+void BufferedSampleSource::saveState(std::ostream& os){
+	// the wrapped source is ahead of the consumed samples by the unread
+	// part of the front block and the back block, both are saved with it
+	pending.wait();
+	os << blockSize << ' ' << position << ' ';
+	for(std::size_t i = 0; i < blockSize; ++i){
+		saveDouble(os, frontU[i]);
+		saveDouble(os, frontV[i]);
+	}
+	for(std::size_t i = 0; i < blockSize; ++i){
+		saveDouble(os, backU[i]);
+		saveDouble(os, backV[i]);
+	}
+	source->saveState(os);
+}
+
+void BufferedSampleSource::loadState(std::istream& is){
+	pending.wait();
+	std::size_t savedBlockSize = 0;
+	is >> savedBlockSize >> position;
+	checkState(is);
+	if(savedBlockSize != blockSize || position > blockSize){
+		throw std::runtime_error("Invalid sample source state");
+	}
+	for(std::size_t i = 0; i < blockSize; ++i){
+		frontU[i] = loadDouble(is);
+		frontV[i] = loadDouble(is);
+	}
+	for(std::size_t i = 0; i < blockSize; ++i){
+		backU[i] = loadDouble(is);
+		backV[i] = loadDouble(is);
+	}
+	checkState(is);
+	source->loadState(is);
+}
+
+void BufferedSampleSource::next(double& u, double& v){
+	if(position == blockSize){
+		pending.get();
+		frontU.swap(backU);
+		frontV.swap(backV);
+		position = 0;
+		startFill();
+	}
+	u = frontU[position];
+	v = frontV[position];
+	++position;
+}
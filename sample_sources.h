@@ -0,0 +1,133 @@
+#ifndef SAMPLE_SOURCES_H
+#define SAMPLE_SOURCES_H
+#include "std_lib_facilities.h"
+#include "environment_classes.h"
+#include <cstdint>
+#include <future>
+#include <random>
+
+// Pluggable sample sequences for RRT_star (see RRT_star::setSampleSource)
+// A SampleSource yields points (u,v) in the unit square [0,1)^2, which the
+// planner scales to the Environment. Low-discrepancy sequences (Halton,
+// Sobol) and stratified jitter cover the square more evenly than i.i.d.
+// uniform samples, so fewer samples are needed for the same coverage.
+// Every source is deterministic for a given seed and only uses integer
+// arithmetic, followed by single correctly rounded conversions, products
+// and divisions (no expression a compiler could contract to FMA), so a
+// seeded run gives the same samples on every IEEE 754 machine and compiler
+// (std::uniform_real_distribution does not).
+//
+// A source is used by one planner (one thread) at a time.
+class SampleSource{
+	public:
+		virtual ~SampleSource() = default;
+		virtual void next(double& u, double& v) = 0; // next sample of the sequence
+		// n samples in bulk, same sequence as n calls to next
+		virtual void fill(double* u, double* v, const std::size_t n);
+		// position in the sequence as text, so that a run can be resumed
+		// from a checkpoint (the default throws std::runtime_error)
+		virtual void saveState(std::ostream& os);
+		virtual void loadState(std::istream& is);
+};
+
+// i.i.d. uniform samples from a seeded mersenne twister, 53 random bits per
+// coordinate
+class UniformSampleSource : public SampleSource{
+	std::mt19937 gen;
+	public:
+		UniformSampleSource(unsigned int seed);
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+};
+
+// Halton sequence in bases 2 and 3. A non-zero seed applies a random shift
+// modulo 1 (Cranley-Patterson rotation) so that differently seeded planners
+// get different, still low-discrepancy, sequences.
+class HaltonSampleSource : public SampleSource{
+	std::uint64_t index = 0;
+	double shiftU = 0;
+	double shiftV = 0;
+	public:
+		HaltonSampleSource(unsigned int seed = 0, std::uint64_t skip = 0);
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+};
+
+// 2D Sobol sequence (van der Corput in base 2 and the second Sobol
+// dimension), generated in Gray code order with one xor per coordinate. A
+// non-zero seed applies a random digital shift (xor scramble).
+class SobolSampleSource : public SampleSource{
+	std::uint32_t index = 0;
+	std::uint32_t stateU = 0;
+	std::uint32_t stateV = 0;
+	std::uint32_t scrambleU = 0;
+	std::uint32_t scrambleV = 0;
+	std::uint32_t directionV[32];
+	public:
+		SobolSampleSource(unsigned int seed = 0);
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+};
+
+// Stratified jitter: the square is split into nx by ny cells, every pass over
+// the grid visits each cell once in a shuffled order and draws a uniform
+// point inside it
+class StratifiedSampleSource : public SampleSource{
+	std::mt19937 gen;
+	int nx = 1;
+	int ny = 1;
+	std::vector<std::uint32_t> cellOrder;
+	std::size_t position = 0; // next entry of cellOrder
+	public:
+		StratifiedSampleSource(const int nx_in, const int ny_in, unsigned int seed);
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+};
+
+// Obstacle-aware sampling: draws from another source and discards the
+// samples that fall inside an obstacle of env, so that only free space is
+// sampled. Gives up after maxAttempts draws in a row and returns the last
+// one (almost fully occupied maps).
+class FreeSpaceSampler : public SampleSource{
+	std::shared_ptr<SampleSource> source;
+	std::shared_ptr<const Environment> env;
+	int maxAttempts = 64;
+	std::uint64_t rejected = 0;
+	public:
+		FreeSpaceSampler(std::shared_ptr<SampleSource> source_in,
+				std::shared_ptr<const Environment> env_in,
+				const int maxAttempts_in = 64);
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+		std::uint64_t getRejected() const; // samples discarded so far
+};
+
+// Precomputed samples of another source, generated in bulk blocks ahead of
+// the extend loop: while the planner consumes one block, the next one is
+// filled by a background task, so sampling costs a buffer read. The sequence
+// is the same as the wrapped source's.
+class BufferedSampleSource : public SampleSource{
+	std::shared_ptr<SampleSource> source;
+	std::size_t blockSize = 4096;
+	std::vector<double> frontU; // block being consumed
+	std::vector<double> frontV;
+	std::vector<double> backU; // block being filled
+	std::vector<double> backV;
+	std::size_t position = 0;
+	std::future<void> pending; // fill of the back block
+	void startFill();
+	public:
+		BufferedSampleSource(std::shared_ptr<SampleSource> source_in,
+				const std::size_t blockSize_in = 4096);
+		~BufferedSampleSource();
+		void next(double& u, double& v) override;
+		void saveState(std::ostream& os) override;
+		void loadState(std::istream& is) override;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "snapshot_format.h"
+#include <cstring>
+
+SnapshotView::SnapshotView(const MappedFile& file){
+	if(file.size() < sizeof(SnapshotHeader)){
+		throw std::runtime_error("Snapshot too small for its header");
+	}
+	std::memcpy(&header, file.data(), sizeof(SnapshotHeader));
+	if(std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0){
+		throw std::runtime_error("Not an RRT snapshot");
+	}
+	if(header.version != SNAPSHOT_VERSION){
+		throw std::runtime_error("Unsupported snapshot version");
+	}
+	if(header.byteOrder != SNAPSHOT_BYTE_ORDER){
+		throw std::runtime_error("Snapshot written with a different byte order");
+	}
+	// the counts are checked against the file size one section at a time,
+	// so corrupt counts cannot overflow the size computation
+	std::uint64_t bodySize = file.size() - sizeof(SnapshotHeader);
+	if(bodySize % 8 != 0){
+		throw std::runtime_error("Snapshot size does not match its header");
+	}
+	std::uint64_t N_values = bodySize / 8;
+	if(header.N_nodes > N_values / 4){
+		throw std::runtime_error("Snapshot size does not match its header");
+	}
+	N_values -= 4 * header.N_nodes;
+	if(header.N_goalNodes > N_values){
+		throw std::runtime_error("Snapshot size does not match its header");
+	}
+	N_values -= header.N_goalNodes;
+	if(N_values % 4 != 0 || header.N_obstacles != N_values / 4){
+		throw std::runtime_error("Snapshot size does not match its header");
+	}
+	// mmap returns page aligned memory and every section is a multiple
+	// of 8 bytes, so the sections can be read in place
+	const char* p = file.data() + sizeof(SnapshotHeader);
+	x_p = reinterpret_cast<const double*>(p);
+	p += 8 * header.N_nodes;
+	y_p = reinterpret_cast<const double*>(p);
+	p += 8 * header.N_nodes;
+	cost_p = reinterpret_cast<const double*>(p);
+	p += 8 * header.N_nodes;
+	parent_p = reinterpret_cast<const std::int64_t*>(p);
+	p += 8 * header.N_nodes;
+	goal_p = reinterpret_cast<const std::uint64_t*>(p);
+	p += 8 * header.N_goalNodes;
+	obstacle_p = reinterpret_cast<const double*>(p);
+	checkTree();
+}
+
+void SnapshotView::checkTree() const{
+	const std::uint64_t N = header.N_nodes;
+	if(N == 0 || parent_p[0] != -1){
+		throw std::runtime_error("Snapshot node 0 is not the root");
+	}
+	// compaction and eviction renumber nodes, so a parent may have a higher
+	// index than its child. Every node is followed up to a node already
+	// known to hang off the root; meeting a node of the current walk again
+	// is a cycle. Each node is walked once.
+	enum : char {UNSEEN, ON_PATH, ROOTED};
+	std::vector<char> state(N, UNSEEN);
+	std::vector<std::uint64_t> path;
+	state[0] = ROOTED;
+	for(std::uint64_t i = 1; i < N; ++i){
+		std::uint64_t node = i;
+		while(state[node] == UNSEEN){
+			std::int64_t parent = parent_p[node];
+			if(parent < 0){
+				throw std::runtime_error("Snapshot has a root other than node 0");
+			}
+			if(std::uint64_t(parent) >= N){
+				throw std::runtime_error("Snapshot parent index out of range");
+			}
+			state[node] = ON_PATH;
+			path.push_back(node);
+			node = parent;
+		}
+		if(state[node] == ON_PATH){
+			throw std::runtime_error("Snapshot parent links form a cycle");
+		}
+		for(std::uint64_t visited : path){
+			state[visited] = ROOTED;
+		}
+		path.clear();
+	}
+	for(std::uint64_t i = 0; i < header.N_goalNodes; ++i){
+		if(goal_p[i] >= N){
+			throw std::runtime_error("Snapshot goal index out of range");
+		}
+	}
+}
+
+const SnapshotHeader& SnapshotView::getHeader() const{
+	return header;
+}
+const double* SnapshotView::getX() const{
+	return x_p;
+}
+const double* SnapshotView::getY() const{
+	return y_p;
+}
+const double* SnapshotView::getCost() const{
+	return cost_p;
+}
+const std::int64_t* SnapshotView::getParent() const{
+	return parent_p;
+}
+const std::uint64_t* SnapshotView::getGoalNodes() const{
+	return goal_p;
+}
+const double* SnapshotView::getObstacles() const{
+	return obstacle_p;
+}
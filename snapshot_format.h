@@ -0,0 +1,71 @@
+#ifndef SNAPSHOT_FORMAT_H
+#define SNAPSHOT_FORMAT_H
+#include "std_lib_facilities.h"
+#include "mapped_file.h"
+#include <cstdint>
+
+// Binary snapshot format for an RRT_star tree, its Environment and goal set
+// Written in one pass by RRT_star::writeSnapshot and read back through a
+// read-only memory map by RRT_star::loadSnapshot. Values are stored in the
+// native byte order of the writing machine (checked on load through
+// byteOrder). Every section is an array of 8 byte values, in this order:
+//
+// SnapshotHeader
+// double  x[N_nodes]            node coordinates
+// double  y[N_nodes]
+// double  cost[N_nodes]         cost to reach the node from the root
+// int64_t parent[N_nodes]       index of the parent node, -1 for the root
+// uint64_t goal[N_goalNodes]    indices of the nodes inside the goal region
+// double  obstacles[4*N_obstacles]  x, y, dx, dy of each obstacle
+//
+// Node 0 is the root of the tree and the only node without a parent; parents
+// may have higher indices than their children, but the links may not form a
+// cycle.
+
+const char SNAPSHOT_MAGIC[8] = {'R','R','T','S','N','A','P','\0'};
+const std::uint32_t SNAPSHOT_VERSION = 1;
+const std::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader{
+	char magic[8];
+	std::uint32_t version = SNAPSHOT_VERSION;
+	std::uint32_t byteOrder = SNAPSHOT_BYTE_ORDER;
+	std::uint64_t N_nodes = 0;
+	std::uint64_t N_goalNodes = 0;
+	std::uint64_t N_obstacles = 0;
+	double envDeltaX = 0; // Environment size
+	double envDeltaY = 0;
+	double startX = 0; // start item
+	double startY = 0;
+	double goalX = 0; // goal region (Obstacle parameters)
+	double goalY = 0;
+	double goalDX = 0;
+	double goalDY = 0;
+};
+
+// Typed view of the sections of a mapped snapshot, pointers stay valid as
+// long as the MappedFile is alive
+// Throws std::runtime_error if the file is not a valid snapshot, including
+// counts that do not match the file size and parent links that do not form a
+// single tree rooted at node 0.
+class SnapshotView{
+	SnapshotHeader header;
+	const double* x_p = nullptr;
+	const double* y_p = nullptr;
+	const double* cost_p = nullptr;
+	const std::int64_t* parent_p = nullptr;
+	const std::uint64_t* goal_p = nullptr;
+	const double* obstacle_p = nullptr;
+	void checkTree() const; // throws unless the parents form one tree
+	public:
+		SnapshotView(const MappedFile& file);
+		const SnapshotHeader& getHeader() const;
+		const double* getX() const;
+		const double* getY() const;
+		const double* getCost() const;
+		const std::int64_t* getParent() const;
+		const std::uint64_t* getGoalNodes() const;
+		const double* getObstacles() const;
+};
+
+#endif
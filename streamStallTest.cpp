@@ -0,0 +1,67 @@
+#include "std_lib_facilities.h"
+#include "environment_classes.h"
+
+#include "tree_classes.h"
+#include "tree_classes.cpp"
+#include "RRT_classes.h"
+#include "RRT_classes.cpp"
+#include <chrono>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Tree stream with a reader that opens the named pipe but never reads: the
+// planner has to finish anyway (events are dropped, not waited for), with
+// and without compaction and a memory budget, and the sink has to shut down
+// without waiting for the reader.
+int main()
+{
+	const std::string fifoName = "treeStream_stalled.fifo";
+	::unlink(fifoName.c_str());
+	if(::mkfifo(fifoName.c_str(), 0644) != 0){
+		std::cout << "Unable to create " << fifoName << std::endl;
+		return 1;
+	}
+	// the stalled reader
+	int readerFd = ::open(fifoName.c_str(), O_RDONLY | O_NONBLOCK);
+
+	Environment env = Environment(200.0, 200.0);
+	std::mt19937 mapGen(5);
+	env.generateRandomObstacles(300, 5.0, mapGen);
+	Point start_point(1.0, 1.0);
+	Obstacle goal_region(170.0, 196.0, 28.0, 8.0);
+	int N_samples = 20000;
+	double radius = 6;
+
+	const char* modes[] = {"plain", "compaction every 5000 nodes", "300 kB memory budget"};
+	bool passed = readerFd >= 0;
+	for(int mode = 0; mode < 3 && passed; ++mode){
+		RRT_star<Point> rrtObject(N_samples, env, goal_region, start_point);
+		rrtObject.setSeed(3);
+		if(mode == 1){
+			rrtObject.setCompactionInterval(5000);
+		}
+		if(mode == 2){
+			rrtObject.setMemoryBudget(300000);
+		}
+		auto begin = std::chrono::steady_clock::now();
+		auto streamSink = std::make_shared<TreeStreamSink>(fifoName, 4096);
+		rrtObject.setStreamSink(streamSink);
+		rrtObject.initiate(radius);
+		double runTime = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - begin).count();
+		std::uint64_t dropped = streamSink->getDropped();
+		rrtObject.setStreamSink(nullptr);
+		streamSink.reset(); // gives up on the reader
+		double totalTime = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - begin).count();
+		std::cout << modes[mode] << ": planning " << runTime << " s, "
+			<< dropped << " events dropped, sink closed after "
+			<< totalTime - runTime << " s" << std::endl;
+		passed = totalTime - runTime < 5;
+	}
+	::close(readerFd);
+	::unlink(fifoName.c_str());
+	std::cout << (passed ? "Stalled reader test passed" : "Stalled reader test FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+import time
+from matplotlib import pyplot as plt
+
+# Live view of a running RRT_star, reads the event stream written by
+# TreeStreamSink (tree_stream.h) while the planner is still running.
+# Works with a regular file or a named pipe (mkfifo treeStream_RRTstar.csv).
+streamFile = 'treeStream_RRTstar.csv'
+refreshPeriod = 0.5 # seconds between redraws
+
+nodes = dict() # index -> (x, y, parent)
+
+plt.ion()
+plt.figure(figsize=(10,10))
+
+with open(streamFile) as stream:
+    buffered = ''
+    lastDraw = 0
+    while True:
+        chunk = stream.read()
+        if chunk:
+            buffered += chunk
+            lines = buffered.split('\n')
+            buffered = lines.pop() # keep a partially written line for later
+            for line in lines:
+                row = line.split(',')
+                if row[0] == 'C': # tree was reordered, all nodes follow again
+                    nodes.clear()
+                    continue
+                if row[0] == 'D': # node removed
+                    nodes.pop(int(row[1]), None)
+                    continue
+                # N (node added) and R (rewire) both carry the node's current parent
+                nodes[int(row[1])] = (float(row[3]), float(row[4]), int(row[2]))
+        if time.time() - lastDraw > refreshPeriod:
+            plt.cla()
+            for (x, y, parent) in nodes.values():
+                if parent in nodes:
+                    plt.plot((nodes[parent][0], x), (nodes[parent][1], y), 'b-', linewidth=0.5)
+            if nodes:
+                x_nodes, y_nodes, _ = zip(*nodes.values())
+                plt.plot(x_nodes, y_nodes, 'r.', markersize=2)
+            plt.title('%d nodes' % len(nodes))
+            plt.pause(0.001)
+            lastDraw = time.time()
+        elif not chunk:
+            time.sleep(0.05)
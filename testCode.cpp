@@ -5,6 +5,11 @@
 #include "tree_classes.cpp"
 #include "RRT_classes.h"
 #include "RRT_classes.cpp"
+#include "cost_metrics.cpp"
+#include "path_processing.h"
+#include "path_processing.cpp"
+#include "parallel_RRT_classes.h"
+#include "parallel_RRT_classes.cpp"
 #include <chrono>
 int main()
 {
@@ -22,6 +27,13 @@ int main()
 	double radius = 2;
 
 	RRT_star<Point> rrtObject(N_samples, env, goal_region, start_point);
+	// minimise the path length (default is the sum of squared edge lengths)
+	// and skip nodes that cannot beat the best path found so far
+	rrtObject.setEdgeCost(euclideanLengthCost<Point>());
+	rrtObject.setCostToGo(regionDistanceCostToGo<Point>(goal_region));
+	// live export of the growing tree, view with streamViewTest.py
+	auto streamSink = std::make_shared<TreeStreamSink>("treeStream_RRTstar.csv");
+	rrtObject.setStreamSink(streamSink);
 	std::cout << "Initiating RRT!" << std::endl;
 	auto start = std::chrono::high_resolution_clock::now();
 	rrtObject.initiate(radius);
@@ -59,6 +71,37 @@ int main()
 	}
 	else std::cout << "Unable to open file" << std::endl;
 
+	// straighten the path within a 50 ms budget
+	PathShortcutter<Point> shortcutter(env, 0.05);
+	auto shortPath = shortcutter.shortcut(finalPath);
+	std::vector<std::shared_ptr<Point>> rawPath;
+	for(auto p_node : finalPath.getPath()){
+		rawPath.push_back(p_node->getItem());
+	}
+	std::cout << "Path length: " << PathShortcutter<Point>::pathLength(rawPath)
+		<< ", " << PathShortcutter<Point>::pathLength(shortPath)
+		<< " after shortcutting (" << finalPath.getPath().size() << " -> "
+		<< shortPath.size() << " waypoints)" << std::endl;
+	std::ofstream shortFile("shortcutPath_RRTstar.csv");
+	if(shortFile.is_open()){
+		PathShortcutter<Point>::printPath(shortPath, shortFile);
+		shortFile.close();
+	}
+
+	// same problem on 4 independently seeded trees sharing the environment,
+	// best of the four paths within 1 second
+	ParallelRRT_star<Point> parallelRRT(4, N_samples, env, goal_region, start_point);
+	parallelRRT.setTimeBudget(1.0);
+	for(std::size_t k = 0; k < parallelRRT.getNumPlanners(); ++k){
+		parallelRRT.getPlanner(k).setEdgeCost(euclideanLengthCost<Point>());
+		parallelRRT.getPlanner(k).setCostToGo(regionDistanceCostToGo<Point>(goal_region));
+	}
+	parallelRRT.initiate(radius);
+	std::cout << "Parallel RRT* (" << parallelRRT.getNumPlanners() << " trees): "
+		<< parallelRRT.getElapsed() << " seconds, best cost "
+		<< parallelRRT.getBestCost() << " (single tree: "
+		<< rrtObject.getBestCost() << ")" << std::endl;
+
 	std::ofstream nodeFile("nodesSampled_RRTstar.csv");
 	if(nodeFile.is_open()){
 		std::cout << "Printing node list!" << std::endl;
@@ -68,6 +111,8 @@ int main()
 	else std::cout << "Unable to open node file" << std::endl;
 
 
+	rrtObject.writeSnapshot("tree_RRTstar.rrtsnap"); // binary tree, environment and goal set
+
 	std::ofstream envFile("environment.csv");
 	if(envFile.is_open()){
 		std::cout << "Printing environment parameters!" << std::endl;
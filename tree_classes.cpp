@@ -49,26 +49,72 @@ void TreeNode<T>::setCost(const double newCost){
 	cost = newCost;
 }
 
+template<typename T>
+std::size_t TreeNode<T>::getIndex() const{
+	return index;
+}
+
+template<typename T>
+void TreeNode<T>::setIndex(const std::size_t newIndex){
+	index = newIndex;
+}
+
+template<typename T>
+void TreeNode<T>::addChild(const std::shared_ptr<TreeNode<T>> child){
+	children.push_back(child);
+}
+
+template<typename T>
+void TreeNode<T>::removeChild(const std::shared_ptr<TreeNode<T>> child){ // order of the remaining children is not kept
+	for(std::size_t i = 0; i < children.size(); ++i){
+		if(children[i].lock() == child){
+			children[i] = children.back();
+			children.pop_back();
+			return;
+		}
+	}
+}
+
+template<typename T>
+const std::vector<std::weak_ptr<TreeNode<T>>>& TreeNode<T>::getChildren() const{
+	return children;
+}
+
 template<typename T>
 // TreeAncestorPath member functions
 TreeAncestorPath<T>::TreeAncestorPath(const TreeNode<T>& node){
 	createAncestorPath(node);
 }
 
+template<typename T>
+TreeAncestorPath<T>::TreeAncestorPath(const std::shared_ptr<TreeNode<T>> node){
+	createAncestorPath(node);
+}
+
 template <typename T>
 void TreeAncestorPath<T>::createAncestorPath(const TreeNode<T>& youngestNode){ //create the path from input TreeNode to top of the Tree
-	path.insert(path.begin(),
-			std::make_shared<TreeNode<T>>(youngestNode));
-	std::shared_ptr<TreeNode<T>> parent = youngestNode.getParent();
-	while(parent != nullptr) {
-		path.insert(path.begin(),parent);
-		std::shared_ptr<TreeNode<T>> currentNode = parent;
-		parent = currentNode->getParent();
-	}	
+	createAncestorPath(std::make_shared<TreeNode<T>>(youngestNode));
+}
+
+template <typename T>
+void TreeAncestorPath<T>::createAncestorPath(const std::shared_ptr<TreeNode<T>> youngestNode){ //create the path from input TreeNode to top of the Tree
+	extractAncestorPath(youngestNode, path);
+}
+
+template <typename T>
+void TreeAncestorPath<T>::extractAncestorPath(const std::shared_ptr<TreeNode<T>> youngestNode,
+		std::vector<std::shared_ptr<TreeNode<T>>>& buffer){
+	buffer.clear();
+	std::shared_ptr<TreeNode<T>> currentNode = youngestNode;
+	while(currentNode != nullptr) {
+		buffer.push_back(currentNode);
+		currentNode = currentNode->getParent();
+	}
+	std::reverse(buffer.begin(), buffer.end()); // top of the Tree first
 }
 
 template <typename T>
-std::vector<std::shared_ptr<TreeNode<T>>> TreeAncestorPath<T>::getPath() const{ // get the stored ancestor path
+const std::vector<std::shared_ptr<TreeNode<T>>>& TreeAncestorPath<T>::getPath() const{ // get the stored ancestor path
 	return path;
 }
 
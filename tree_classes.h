@@ -13,6 +13,8 @@ class TreeNode{
 		std::shared_ptr<T> item_p = nullptr;
 		std::shared_ptr<TreeNode<T>> parent_p = nullptr;
 		double cost = 0;
+		std::size_t index = 0; // position of the node in the storage of its tree (e.g. RRT_star::nodeList)
+		std::vector<std::weak_ptr<TreeNode<T>>> children; // maintained by the tree owner through addChild/removeChild, setParent does not touch it
 	public:
 		TreeNode();
 		TreeNode(std::shared_ptr<T> item_in);
@@ -24,17 +26,30 @@ class TreeNode{
 		std::shared_ptr<TreeNode<T>> getParent() const;
 		double getCost() const;
 		void setCost(const double newCost);
+		std::size_t getIndex() const;
+		void setIndex(const std::size_t newIndex);
+		void addChild(const std::shared_ptr<TreeNode<T>> child);
+		void removeChild(const std::shared_ptr<TreeNode<T>> child);
+		const std::vector<std::weak_ptr<TreeNode<T>>>& getChildren() const;
 };
 
 // TreeAncestorPath contains a vector that is the path from one TreeNode to the top of the Tree that it contains. It calculates the ancestor path by getting the parents of each TreeNode until it finds the TreeNode without a parent.
+// The path is ordered from the top of the Tree to the youngest node; it is built by appending ancestors and reversing once (linear in the path length).
 template <typename T>
 class TreeAncestorPath{
 	protected:
 		std::vector<std::shared_ptr<TreeNode<T>>> path;
 	public:
-		TreeAncestorPath(const TreeNode<T>& node);
+		TreeAncestorPath(const TreeNode<T>& node); // copies node, prefer the shared_ptr version
+		TreeAncestorPath(const std::shared_ptr<TreeNode<T>> node);
 		void createAncestorPath(const TreeNode<T>& youngestNode);
-		std::vector<std::shared_ptr<TreeNode<T>>> getPath() const;
+		void createAncestorPath(const std::shared_ptr<TreeNode<T>> youngestNode);
+		// writes the ancestor path of youngestNode into buffer (replacing its
+		// contents), reusing the buffer's capacity so repeated extraction does
+		// not allocate
+		static void extractAncestorPath(const std::shared_ptr<TreeNode<T>> youngestNode,
+				std::vector<std::shared_ptr<TreeNode<T>>>& buffer);
+		const std::vector<std::shared_ptr<TreeNode<T>>>& getPath() const;
 		void printPath(std::ofstream& os) const;
 };
 
@@ -0,0 +1,146 @@
+#include "tree_stream.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+TreeStreamSink::TreeStreamSink(const std::string& filename_in,
+		std::size_t capacity, std::size_t batchSize_in){
+	filename = filename_in;
+	batchSize = std::max<std::size_t>(batchSize_in, 1);
+	std::size_t ringSize = 1;
+	while(ringSize < capacity){
+		ringSize <<= 1;
+	}
+	ring.resize(ringSize);
+	mask = ringSize - 1;
+	writer = std::thread(&TreeStreamSink::writerLoop, this);
+}
+
+TreeStreamSink::~TreeStreamSink(){
+	stopping.store(true, std::memory_order_release);
+	writer.join();
+}
+
+bool TreeStreamSink::push(const TreeEvent& event){
+	std::size_t t = tail.load(std::memory_order_relaxed);
+	std::size_t h = head.load(std::memory_order_acquire);
+	if(t - h > mask){ // full
+		dropped.store(dropped.load(std::memory_order_relaxed) + 1,
+				std::memory_order_relaxed);
+		return false;
+	}
+	ring[t & mask] = event;
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+std::size_t TreeStreamSink::getFreeSlots() const{
+	return ring.size() - (tail.load(std::memory_order_relaxed)
+			- head.load(std::memory_order_acquire));
+}
+
+std::size_t TreeStreamSink::getCapacity() const{
+	return ring.size();
+}
+
+std::uint64_t TreeStreamSink::getDropped() const{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+int TreeStreamSink::openStream(){
+	// O_NONBLOCK: opening a FIFO for writing fails with ENXIO instead of
+	// blocking until a reader opens it, so the open can be retried and
+	// abandoned on stop. Writes stay non-blocking as well (see writeAll).
+	while(!stopping.load(std::memory_order_acquire)){
+		int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0644);
+		if(fd >= 0 || errno != ENXIO){
+			return fd;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	return -1;
+}
+
+bool TreeStreamSink::writeAll(const int fd, const char* data, std::size_t size){
+	// a full pipe is waited on in short steps; once the sink is stopping, a
+	// reader that takes nothing for a second is given up on
+	int stalledSteps = 0;
+	while(size > 0){
+		ssize_t written = ::write(fd, data, size);
+		if(written > 0){
+			data += written;
+			size -= written;
+			stalledSteps = 0;
+			continue;
+		}
+		if(written < 0 && errno == EINTR){
+			continue;
+		}
+		if(written < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+			return false; // e.g. EPIPE, the reader closed the pipe
+		}
+		if(stopping.load(std::memory_order_acquire) && ++stalledSteps > 20){
+			return false;
+		}
+		pollfd waitFd = {fd, POLLOUT, 0};
+		::poll(&waitFd, 1, 50);
+	}
+	return true;
+}
+
+void TreeStreamSink::writerLoop(){
+	// a reader closing the pipe turns into EPIPE for this thread instead of
+	// a SIGPIPE that ends the process
+	sigset_t pipeSignal;
+	sigemptyset(&pipeSignal);
+	sigaddset(&pipeSignal, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+
+	int fd = openStream();
+	if(fd < 0){
+		if(stopping.load(std::memory_order_acquire)){
+			return; // no reader ever opened the FIFO
+		}
+		std::cerr << "Unable to open tree stream " << filename << std::endl;
+	}
+	// events are consumed (and discarded once the file is unusable)
+	std::string batch;
+	char line[160];
+	while(true){
+		bool stop = stopping.load(std::memory_order_acquire);
+		std::size_t h = head.load(std::memory_order_relaxed);
+		std::size_t t = tail.load(std::memory_order_acquire);
+		if(h == t){
+			if(stop){
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			continue;
+		}
+		std::size_t n = std::min(t - h, batchSize);
+		batch.clear();
+		for(std::size_t i = h; i < h + n && fd >= 0; ++i){
+			const TreeEvent& e = ring[i & mask];
+			int length = std::snprintf(line, sizeof(line),
+				"%c,%llu,%lld,%.17g,%.17g,%.17g\n", e.type,
+				(unsigned long long)e.index, (long long)e.parent,
+				e.x, e.y, e.cost);
+			batch.append(line, length);
+		}
+		// the batch is formatted, its slots can take new events while the
+		// writer waits for the reader
+		head.store(h + n, std::memory_order_release);
+		if(fd >= 0 && !writeAll(fd, batch.data(), batch.size())){
+			::close(fd);
+			fd = -1;
+		}
+	}
+	if(fd >= 0){
+		::close(fd);
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef TREE_STREAM_H
+#define TREE_STREAM_H
+#include "std_lib_facilities.h"
+#include <atomic>
+#include <cstdint>
+
+// Streaming export of tree growth while RRT_star runs
+// The planner pushes TreeEvents into a bounded single-producer/single-consumer
+// ring buffer; a background thread drains it in batches and writes them as
+// CSV lines to a file or named pipe, flushing after every batch so that a
+// reader (e.g. streamViewTest.py) sees the tree grow live.
+// push() never blocks or allocates: if the buffer is full the event is
+// dropped and counted (see getDropped), so the planning loop never waits on
+// I/O. A drop leaves readers with a wrong tree; RRT_star then sends 'C' and
+// the whole tree again, a part at a time while the ring has room (see
+// getFreeSlots), so a reader that falls behind catches up once it reads
+// again. The writer thread does not block on a stalled reader either: the
+// file is written without blocking and the destructor gives up on a reader
+// that reads nothing for a second.
+//
+// Line format, one event per line:
+// N,index,parent,x,y,cost  node added (parent -1 for the root)
+// R,index,parent,x,y,cost  node rewired to a new parent with a new cost
+// D,index,-1,0,0,0         node removed (memory budget eviction); the last
+//                          node then moves to the free index and is sent again
+// C,0,-1,0,0,0             readers drop their copy of the tree, every node is
+//                          sent again (new sink, RRT_star::compactTree
+//                          changed the node indices, or a resync after drops)
+
+struct TreeEvent{
+	char type = 'N'; // 'N' node added, 'R' rewire, 'D' removal, 'C' compaction
+	std::uint64_t index = 0;
+	std::int64_t parent = -1;
+	double x = 0;
+	double y = 0;
+	double cost = 0;
+};
+
+class TreeStreamSink{
+	std::string filename;
+	std::vector<TreeEvent> ring;
+	std::size_t mask = 0; // ring size - 1, ring size is a power of two
+	std::size_t batchSize = 1024;
+	alignas(64) std::atomic<std::size_t> head{0}; // next event to write out (consumer)
+	alignas(64) std::atomic<std::size_t> tail{0}; // next free slot (producer)
+	std::atomic<std::uint64_t> dropped{0};
+	std::atomic<bool> stopping{false};
+	std::thread writer;
+
+	void writerLoop();
+	int openStream(); // waits for a FIFO reader, -1 on stop or error
+	bool writeAll(const int fd, const char* data, std::size_t size); // false if the reader is gone or stalled on stop
+	public:
+		// capacity is rounded up to a power of two; the file (or pipe) is
+		// opened by the background thread without blocking, retrying until a
+		// FIFO gets a reader, so neither the caller nor the destructor wait
+		// for one
+		TreeStreamSink(const std::string& filename_in,
+				std::size_t capacity = 1 << 16,
+				std::size_t batchSize_in = 1024);
+		~TreeStreamSink(); // drains the remaining events and joins the writer
+		TreeStreamSink(const TreeStreamSink&) = delete;
+		TreeStreamSink& operator=(const TreeStreamSink&) = delete;
+
+		bool push(const TreeEvent& event); // false if the event was dropped
+		std::size_t getFreeSlots() const; // events that fit into the ring right now (producer side)
+		std::size_t getCapacity() const;
+		std::uint64_t getDropped() const;
+};
+
+#endif